@@ -0,0 +1,214 @@
+/***********************************************************************
+ * Source File:
+ *    ATTACKS : Precomputed attack sets for every piece
+ * Summary:
+ *    Builds the tables once at startup. The magics themselves are
+ *    found by trial: random sparse numbers are tried until one maps
+ *    every blocker pattern of a square to a slot without a conflicting
+ *    attack set.
+ ************************************************************************/
+
+#include "attacks.h"
+#define NDEBUG
+#include <cassert>
+
+Magic rookMagics[64];
+Magic bishopMagics[64];
+Bitboard kingAttacks[64];
+Bitboard knightAttacks[64];
+Bitboard pawnAttacks[2][64];
+Bitboard betweenBB[64][64];
+Bitboard lineBB[64][64];
+
+// one slot per blocker pattern of every square
+static Bitboard rookTable[0x19000];
+static Bitboard bishopTable[0x1480];
+
+static const int ROOK_DELTAS[4][2]   = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+static const int BISHOP_DELTAS[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+static const int KING_DELTAS[8][2]   = { {1, 0}, {-1, 0}, {0, 1}, {0, -1},
+                                         {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+static const int KNIGHT_DELTAS[8][2] = { {2, 1}, {2, -1}, {-2, 1}, {-2, -1},
+                                         {1, 2}, {1, -2}, {-1, 2}, {-1, -2} };
+
+/***************************************************
+ * SLIDING ATTACKS
+ * Walk each ray until it leaves the board or hits
+ * a blocker. Only used to build the tables
+ ***************************************************/
+static Bitboard slidingAttacks(int sq, Bitboard occupied, const int deltas[4][2])
+{
+   Bitboard attacks = BB_EMPTY;
+   for (int d = 0; d < 4; d++)
+   {
+      int r = sq / 8 + deltas[d][0];
+      int c = sq % 8 + deltas[d][1];
+      while (r >= 0 && r < 8 && c >= 0 && c < 8)
+      {
+         attacks |= squareBB(r * 8 + c);
+         if (occupied & squareBB(r * 8 + c))
+            break;
+         r += deltas[d][0];
+         c += deltas[d][1];
+      }
+   }
+   return attacks;
+}
+
+#ifndef USE_PEXT
+/***************************************************
+ * RANDOM
+ * xorshift64* so the magics come out the same on
+ * every run and every platform
+ ***************************************************/
+static Bitboard randomBB(Bitboard& state)
+{
+   state ^= state >> 12;
+   state ^= state << 25;
+   state ^= state >> 27;
+   return state * 2685821657736338717ULL;
+}
+#endif
+
+/***************************************************
+ * INIT MAGICS
+ * Fill in the mask, magic and table slice of every
+ * square for one kind of slider
+ ***************************************************/
+static void initMagics(Magic magics[64], Bitboard* table, const int deltas[4][2])
+{
+#ifndef USE_PEXT
+   static Bitboard occupancy[4096];
+   static Bitboard reference[4096];
+   static int      epoch[4096];
+   // seeds per row known to find every magic after few attempts
+   static const Bitboard SEEDS[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+   static int attempt = 0; // shared by both sliders so epoch never goes stale
+#endif
+
+   for (int sq = 0; sq < 64; sq++)
+   {
+      Magic& m = magics[sq];
+
+      // the edges never block anything further along the ray
+      Bitboard edges = ((rowBB(0) | rowBB(7)) & ~rowBB(sq / 8)) |
+                       ((colBB(0) | colBB(7)) & ~colBB(sq % 8));
+      m.mask  = slidingAttacks(sq, BB_EMPTY, deltas) & ~edges;
+      m.shift = 64 - popCount(m.mask);
+      m.attacks = (sq == 0) ? table : magics[sq - 1].attacks + (1 << (64 - magics[sq - 1].shift));
+
+      // enumerate every subset of the mask (carry-rippler)
+#ifdef USE_PEXT
+      m.magic = 0;
+      Bitboard b = BB_EMPTY;
+      do
+      {
+         m.attacks[_pext_u64(b, m.mask)] = slidingAttacks(sq, b, deltas);
+         b = (b - m.mask) & m.mask;
+      } while (b);
+#else
+      int size = 0;
+      Bitboard b = BB_EMPTY;
+      do
+      {
+         occupancy[size] = b;
+         reference[size] = slidingAttacks(sq, b, deltas);
+         size++;
+         b = (b - m.mask) & m.mask;
+      } while (b);
+
+      // try sparse random numbers until one has no destructive collisions
+      Bitboard state = SEEDS[sq / 8];
+      for (int i = 0; i < size; )
+      {
+         do
+            m.magic = randomBB(state) & randomBB(state) & randomBB(state);
+         while (popCount((m.mask * m.magic) >> 56) < 6);
+
+         attempt++;
+         for (i = 0; i < size; i++)
+         {
+            unsigned int idx = m.index(occupancy[i]);
+            if (epoch[idx] < attempt)
+            {
+               epoch[idx] = attempt;
+               m.attacks[idx] = reference[i];
+            }
+            else if (m.attacks[idx] != reference[i])
+               break;
+         }
+      }
+#endif
+   }
+}
+
+/***************************************************
+ * STEP ATTACKS
+ * The squares one step away in each of the given
+ * directions that are still on the board
+ ***************************************************/
+static Bitboard stepAttacks(int sq, const int deltas[][2], int count)
+{
+   Bitboard attacks = BB_EMPTY;
+   for (int d = 0; d < count; d++)
+   {
+      int r = sq / 8 + deltas[d][0];
+      int c = sq % 8 + deltas[d][1];
+      if (r >= 0 && r < 8 && c >= 0 && c < 8)
+         attacks |= squareBB(r * 8 + c);
+   }
+   return attacks;
+}
+
+/***************************************************
+ * INIT LEAPERS AND LINES
+ * The fixed tables. Must run after the magics since
+ * the lines are built from slider attacks
+ ***************************************************/
+static void initLeapersAndLines()
+{
+   static const int WHITE_PAWN_DELTAS[2][2] = { {1, -1}, {1, 1} };
+   static const int BLACK_PAWN_DELTAS[2][2] = { {-1, -1}, {-1, 1} };
+
+   for (int sq = 0; sq < 64; sq++)
+   {
+      kingAttacks[sq]       = stepAttacks(sq, KING_DELTAS, 8);
+      knightAttacks[sq]     = stepAttacks(sq, KNIGHT_DELTAS, 8);
+      pawnAttacks[1][sq]    = stepAttacks(sq, WHITE_PAWN_DELTAS, 2);
+      pawnAttacks[0][sq]    = stepAttacks(sq, BLACK_PAWN_DELTAS, 2);
+   }
+
+   for (int sq1 = 0; sq1 < 64; sq1++)
+      for (int sq2 = 0; sq2 < 64; sq2++)
+      {
+         betweenBB[sq1][sq2] = lineBB[sq1][sq2] = BB_EMPTY;
+         if (sq1 == sq2)
+            continue;
+         if (rookAttacks(sq1, BB_EMPTY) & squareBB(sq2))
+         {
+            lineBB[sq1][sq2] = (rookAttacks(sq1, BB_EMPTY) & rookAttacks(sq2, BB_EMPTY))
+                             | squareBB(sq1) | squareBB(sq2);
+            betweenBB[sq1][sq2] = rookAttacks(sq1, squareBB(sq2)) & rookAttacks(sq2, squareBB(sq1));
+         }
+         else if (bishopAttacks(sq1, BB_EMPTY) & squareBB(sq2))
+         {
+            lineBB[sq1][sq2] = (bishopAttacks(sq1, BB_EMPTY) & bishopAttacks(sq2, BB_EMPTY))
+                             | squareBB(sq1) | squareBB(sq2);
+            betweenBB[sq1][sq2] = bishopAttacks(sq1, squareBB(sq2)) & bishopAttacks(sq2, squareBB(sq1));
+         }
+      }
+}
+
+/***************************************************
+ * INIT ATTACKS
+ * Build every table exactly once, even when called
+ * from several threads at the same time
+ ***************************************************/
+void initAttacks()
+{
+   static const bool initialized = (initMagics(rookMagics,   rookTable,   ROOK_DELTAS),
+                                    initMagics(bishopMagics, bishopTable, BISHOP_DELTAS),
+                                    initLeapersAndLines(),
+                                    true);
+   (void)initialized;
+}
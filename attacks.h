@@ -0,0 +1,84 @@
+/***********************************************************************
+ * Header File:
+ *    ATTACKS : Precomputed attack sets for every piece
+ * Summary:
+ *    Kings, knights and pawns attack a fixed set of squares from each
+ *    square, so those are simple tables. Rooks, bishops and queens
+ *    attack every square along their rays up to and including the
+ *    first blocker. Rather than walking the rays, every possible
+ *    blocker pattern is precomputed so the attack set is a single table
+ *    lookup. The index into the table comes from a magic multiply, or
+ *    from PEXT when the target CPU has BMI2.
+ ************************************************************************/
+
+#pragma once
+
+#include "bitboard.h"
+
+// PEXT is only fast on some BMI2 CPUs; define NO_PEXT to use magics anyway
+#if defined(__BMI2__) && !defined(NO_PEXT)
+#include <immintrin.h>
+#define USE_PEXT
+#endif
+
+/***************************************************
+ * MAGIC
+ * Everything needed to find the attacks of one slider
+ * on one square
+ ***************************************************/
+struct Magic
+{
+   Bitboard  mask;    // squares whose occupancy matters
+   Bitboard  magic;   // multiplier that hashes the masked occupancy
+   Bitboard* attacks; // this square's slice of the attack table
+   int       shift;   // 64 minus the number of bits in the mask
+
+   unsigned int index(Bitboard occupied) const
+   {
+#ifdef USE_PEXT
+      return (unsigned int)_pext_u64(occupied, mask);
+#else
+      return (unsigned int)(((occupied & mask) * magic) >> shift);
+#endif
+   }
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+extern Bitboard kingAttacks[64];
+extern Bitboard knightAttacks[64];
+extern Bitboard pawnAttacks[2][64];  // indexed by [isWhite][square]
+extern Bitboard betweenBB[64][64];   // squares strictly between two on a line
+extern Bitboard lineBB[64][64];      // the whole line through two squares
+
+// build the tables. Safe to call more than once
+void initAttacks();
+
+/***************************************************
+ * SLIDER ATTACKS
+ * Every square a slider on sq attacks given the
+ * occupied squares of the board
+ ***************************************************/
+inline Bitboard rookAttacks(int sq, Bitboard occupied)
+{
+   const Magic& m = rookMagics[sq];
+   return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied)
+{
+   const Magic& m = bishopMagics[sq];
+   return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied)
+{
+   return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied);
+}
+
+// are the three squares on one rank, file or diagonal?
+inline bool aligned(int sq1, int sq2, int sq3)
+{
+   return (lineBB[sq1][sq2] & squareBB(sq3)) != 0;
+}
@@ -0,0 +1,74 @@
+/***********************************************************************
+ * Header File:
+ *    BITBOARD : A set of squares packed into 64 bits
+ * Summary:
+ *    Bit N of a bitboard is the square with location N, the same
+ *    numbering Position uses (row * 8 + col). Set operations over
+ *    bitboards replace walking the board one square at a time.
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+typedef uint64_t Bitboard;
+
+const Bitboard BB_EMPTY = 0ULL;
+const Bitboard BB_ALL   = ~0ULL;
+const Bitboard BB_ROW_0 = 0x00000000000000FFULL;
+const Bitboard BB_COL_0 = 0x0101010101010101ULL;
+
+/***************************************************
+ * BITBOARD HELPERS
+ ***************************************************/
+
+// the bitboard containing only the given square
+inline Bitboard squareBB(int sq) { return 1ULL << sq; }
+
+// the bitboard of a whole row or column
+inline Bitboard rowBB(int row) { return BB_ROW_0 << (8 * row); }
+inline Bitboard colBB(int col) { return BB_COL_0 << col;       }
+
+// number of squares in the set
+inline int popCount(Bitboard bb)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+   return (int)__popcnt64(bb);
+#elif defined(_MSC_VER)
+   return (int)(__popcnt((unsigned int)bb) + __popcnt((unsigned int)(bb >> 32)));
+#else
+   return __builtin_popcountll(bb);
+#endif
+}
+
+// lowest square in a non-empty set
+inline int lsb(Bitboard bb)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+   unsigned long index;
+   _BitScanForward64(&index, bb);
+   return (int)index;
+#elif defined(_MSC_VER)
+   unsigned long index;
+   if (_BitScanForward(&index, (unsigned long)bb))
+      return (int)index;
+   _BitScanForward(&index, (unsigned long)(bb >> 32));
+   return (int)index + 32;
+#else
+   return __builtin_ctzll(bb);
+#endif
+}
+
+// remove and return the lowest square in a non-empty set
+inline int popLsb(Bitboard& bb)
+{
+   int sq = lsb(bb);
+   bb &= bb - 1;
+   return sq;
+}
+
+// more than one square in the set?
+inline bool moreThanOne(Bitboard bb) { return (bb & (bb - 1)) != 0; }
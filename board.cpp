@@ -3,43 +3,128 @@
  ************************************************************************/
 
 #include "board.h"
+#include "attacks.h"
+#include "movegen.h"
+#include "eval.h"
 #define NDEBUG
 #include <cassert>
+#include <cstdio>
 using namespace std;
 
-Board::Board(ogstream* pgout, bool noReset) : currentMove(-1), pgout(pgout)
+Board::Board(bool noReset) : currentMove(-1),
+    bbPieces(), bbColour(), bbOccupied(BB_EMPTY),
+    castling(0), enPassant(-1), halfmoveClock(0), key(0),
+    psqMgTotal(0), psqEgTotal(0), phase(0)
 {
+    initAttacks();
+    initZobrist();
+    initPSQT();
+    states.reserve(MAX_PLY);
+    for (int isWhite = 0; isWhite < 2; isWhite++)
+        for (int pt = SPACE; pt <= PAWN; pt++)
+            spares[isWhite][pt].reserve(pt == SPACE ? 32 : 8);
+
     if (!noReset)
         reset(false);
 }
 
+Board::Board(const Board& rhs) : currentMove(-1),
+    bbPieces(), bbColour(), bbOccupied(BB_EMPTY),
+    castling(0), enPassant(-1), halfmoveClock(0), key(0),
+    psqMgTotal(0), psqEgTotal(0), phase(0)
+{
+    states.reserve(MAX_PLY);
+    copy(rhs);
+}
+
 Board::~Board()
 {
     free();
 }
 
 /**************************************************************
- * BOARD : DISPLAY
- * Display the board
+ * BOARD : ASSIGNMENT
+ * Make this board a copy of another. The pieces already here
+ * go back to the spares and are reused for the copy, so after
+ * the first few copies this allocates nothing. That makes it a
+ * cheap way to give each search thread its own board.
  *************************************************************/
-void Board::display(const Position source, const Interface& ui, const set<Move>& possible) const
+Board& Board::operator = (const Board& rhs)
 {
-    // draw the base board
-    pgout->drawBoard();
-
-    // draw the hover and select stuff
-    pgout->drawHover(ui.getHoverPosition());
-    pgout->drawSelected(ui.getSelectPosition());
+    if (this != &rhs)
+    {
+        releasePieces();
+        copy(rhs);
+    }
+    return *this;
+}
 
-    // draw the possible moves
-    set<Move> ::iterator it;
-    for (it = possible.begin(); it != possible.end(); ++it)
-        pgout->drawPossible(it->getDes().getLocation());
+/**************************************************************
+ * BOARD : CLONE PIECE
+ * A piece identical to another, including when it last moved
+ *************************************************************/
+Piece* Board::clonePiece(const Piece* p)
+{
+    if (p == nullptr)
+        return nullptr;
+    Piece* clone = newPiece(p->getPieceType(), p->getIsWhite(), p->getPosition().getLocation());
+    clone->setLastMove(p->getLastMove());
+    return clone;
+}
 
-    // draw the pieces
+/**************************************************************
+ * BOARD : COPY
+ * Give this (empty) board its own copy of every piece and all
+ * the state of another, undo stack included, so moves made
+ * before the copy can still be taken back on it. The pieces
+ * come from the spares; the bitboards, key and evaluation are
+ * rebuilt from them rather than copied
+ *************************************************************/
+void Board::copy(const Board& rhs)
+{
     for (int r = 0; r < 8; r++)
         for (int c = 0; c < 8; c++)
-            board[r][c]->display(pgout);
+            board[r][c] = clonePiece(rhs.board[r][c]);
+
+    for (size_t i = 0; i < rhs.states.size(); i++)
+    {
+        BoardState state = rhs.states[i];
+        state.captured = clonePiece(state.captured);
+        state.pawn = clonePiece(state.pawn);
+        states.push_back(state);
+    }
+
+    currentMove = rhs.currentMove;
+    castling = rhs.castling;
+    enPassant = rhs.enPassant;
+    halfmoveClock = rhs.halfmoveClock;
+    moves = rhs.moves;
+    rebuildBitboards();
+    assert(key == rhs.key);
+}
+
+/**************************************************************
+ * BOARD : GENERATE MOVES
+ * Every move the side to move can make, written into one list
+ * OUTPUT list    The list the moves are appended to
+ *************************************************************/
+void Board::generateMoves(MoveList& list) const
+{
+    Bitboard pieces = getColour(whiteTurn());
+    while (pieces)
+    {
+        int sq = popLsb(pieces);
+        board[sq / 8][sq % 8]->getMoves(list, *this);
+    }
+}
+
+/**************************************************************
+ * BOARD : PIECE ON
+ * The type of the piece on a square, SPACE if none
+ *************************************************************/
+PieceType Board::pieceOn(int sq) const
+{
+    return board[sq / 8][sq % 8]->getPieceType();
 }
 
 /**************************************************************
@@ -50,6 +135,31 @@ Piece* Board::pawnFactory(int row, int col, bool isWhite) {
     return new Pawn(row, col, isWhite);
 }
 
+/**************************************************************
+ * BOARD : PIECE FACTORY
+ * Create a piece of any type
+ *************************************************************/
+Piece* Board::pieceFactory(PieceType pt, int row, int col, bool isWhite)
+{
+    switch (pt)
+    {
+    case KING:
+        return new King(row, col, isWhite);
+    case QUEEN:
+        return new Queen(row, col, isWhite);
+    case ROOK:
+        return new Rook(row, col, isWhite);
+    case BISHOP:
+        return new Bishop(row, col, isWhite);
+    case KNIGHT:
+        return new Knight(row, col, isWhite);
+    case PAWN:
+        return pawnFactory(row, col, isWhite);
+    default:
+        return new Space(row, col);
+    }
+}
+
 /**************************************************************
  * BOARD : RESET
  * Just fill the board with the known pieces
@@ -68,34 +178,334 @@ void Board::reset(bool fFree)
     // pawns
     for (int c = 0; c < 8; c++)
     {
-        board[1][c] = pawnFactory(1, c, false);
-        board[6][c] = pawnFactory(6, c, true);
+        board[1][c] = pawnFactory(1, c, true);
+        board[6][c] = pawnFactory(6, c, false);
     }
 
-    // black
-    board[0][0] = new Rook(0, 0, false);
-    board[0][1] = new Knight(0, 1, false);
-    board[0][2] = new Bishop(0, 2, false);
-    board[0][3] = new Queen(0, 3, false);
-    board[0][4] = new King(0, 4, false);
-    board[0][5] = new Bishop(0, 5, false);
-    board[0][6] = new Knight(0, 6, false);
-    board[0][7] = new Rook(0, 7, false);
     // white
-    board[7][0] = new Rook(7, 0, true);
-    board[7][1] = new Knight(7, 1, true);
-    board[7][2] = new Bishop(7, 2, true);
-    board[7][3] = new Queen(7, 3, true);
-    board[7][4] = new King(7, 4, true);
-    board[7][5] = new Bishop(7, 5, true);
-    board[7][6] = new Knight(7, 6, true);
-    board[7][7] = new Rook(7, 7, true);
+    board[0][0] = new Rook(0, 0, true);
+    board[0][1] = new Knight(0, 1, true);
+    board[0][2] = new Bishop(0, 2, true);
+    board[0][3] = new Queen(0, 3, true);
+    board[0][4] = new King(0, 4, true);
+    board[0][5] = new Bishop(0, 5, true);
+    board[0][6] = new Knight(0, 6, true);
+    board[0][7] = new Rook(0, 7, true);
+    // black
+    board[7][0] = new Rook(7, 0, false);
+    board[7][1] = new Knight(7, 1, false);
+    board[7][2] = new Bishop(7, 2, false);
+    board[7][3] = new Queen(7, 3, false);
+    board[7][4] = new King(7, 4, false);
+    board[7][5] = new Bishop(7, 5, false);
+    board[7][6] = new Knight(7, 6, false);
+    board[7][7] = new Rook(7, 7, false);
 
     // reset the moves
     currentMove = 0;
+    castling = CASTLE_ALL;
+    enPassant = -1;
+    halfmoveClock = 0;
+    moves.clear();
+    rebuildBitboards();
     assertBoard();
 }
 
+/**************************************************************
+ * FEN FIELD
+ * Split the next space separated field off the front of a FEN
+ * record, empty when there are none left
+ *************************************************************/
+static string_view fenField(string_view& rest)
+{
+    size_t start = rest.find_first_not_of(' ');
+    if (start == string_view::npos)
+    {
+        rest = string_view();
+        return rest;
+    }
+    rest.remove_prefix(start);
+    size_t end = rest.find(' ');
+    string_view field = rest.substr(0, end);
+    rest.remove_prefix(end == string_view::npos ? rest.size() : end);
+    return field;
+}
+
+/**************************************************************
+ * FEN NUMBER
+ * A move counter, or -1 if the field is not a number
+ *************************************************************/
+static int fenNumber(string_view field)
+{
+    if (field.empty() || field.size() > 6)
+        return -1;
+    int n = 0;
+    for (char digit : field)
+    {
+        if (digit < '0' || digit > '9')
+            return -1;
+        n = n * 10 + (digit - '0');
+    }
+    return n;
+}
+
+/**************************************************************
+ * FEN HAS
+ * Does a square of a placement being read hold a given piece?
+ *************************************************************/
+static bool fenHas(const PieceType types[], const bool colours[], int sq, PieceType pt, bool isWhite)
+{
+    return types[sq] == pt && colours[sq] == isWhite;
+}
+
+/**************************************************************
+ * BOARD : LOAD FEN
+ * Set up the position described by a FEN record: the pieces,
+ * the side to move, the castling rights, the en-passant square
+ * and the move counters. The counters are optional; everything
+ * else must be there. Positions no game could reach, such as a
+ * pawn on the last rank or the side not to move in check, are
+ * refused, and castling rights the pieces cannot have are
+ * dropped. The record is read in one pass without copying it,
+ * and the pieces come from the spares, so loading one position
+ * after another does not allocate.
+ * INPUT fen   The record, such as
+ *             "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+ * Throws a string describing the problem if it cannot be read
+ *************************************************************/
+void Board::loadFEN(string_view fen)
+{
+    string_view rest = fen;
+    string_view placement = fenField(rest);
+    string_view side = fenField(rest);
+    string_view rights = fenField(rest);
+    string_view ep = fenField(rest);
+    string_view halfmoveField = fenField(rest);
+    string_view fullmoveField = fenField(rest);
+    if (ep.empty())
+        throw string("Error parsing FEN: missing fields in \"") + string(fen) + "\"";
+    if (side != "w" && side != "b")
+        throw string("Error parsing FEN: bad side to move \"") + string(side) + "\"";
+
+    // read the whole placement before touching the board
+    PieceType types[64];
+    bool colours[64] = {};
+    int kings[2] = { 0, 0 };
+    int row = 7;
+    int col = 0;
+    for (char letter : placement)
+    {
+        if (letter == '/')
+        {
+            if (col != 8 || row == 0)
+                throw string("Error parsing FEN: bad rank in \"") + string(placement) + "\"";
+            row--;
+            col = 0;
+        }
+        else if (letter >= '1' && letter <= '8')
+        {
+            for (int n = letter - '0'; n > 0; n--, col++)
+                if (col < 8)
+                    types[row * 8 + col] = SPACE;
+            if (col > 8)
+                throw string("Error parsing FEN: bad rank in \"") + string(placement) + "\"";
+        }
+        else
+        {
+            PieceType pt = SPACE;
+            switch (letter | 0x20)
+            {
+                case 'k': pt = KING;   break;
+                case 'q': pt = QUEEN;  break;
+                case 'r': pt = ROOK;   break;
+                case 'b': pt = BISHOP; break;
+                case 'n': pt = KNIGHT; break;
+                case 'p': pt = PAWN;   break;
+            }
+            if (pt == SPACE || col >= 8)
+                throw string("Error parsing FEN: bad piece '") + letter + "'";
+            bool isWhite = letter < 'a';
+            if (pt == KING)
+                kings[isWhite]++;
+            types[row * 8 + col] = pt;
+            colours[row * 8 + col] = isWhite;
+            col++;
+        }
+    }
+    if (row != 0 || col != 8)
+        throw string("Error parsing FEN: bad placement \"") + string(placement) + "\"";
+    if (kings[0] != 1 || kings[1] != 1)
+        throw string("Error parsing FEN: each side needs one king in \"") + string(placement) + "\"";
+
+    // the same placement as sets of squares, to check it could arise in a game
+    Bitboard pieces[2][7] = {};
+    Bitboard occupied = BB_EMPTY;
+    for (int sq = 0; sq < 64; sq++)
+        if (types[sq] != SPACE)
+        {
+            pieces[colours[sq]][types[sq]] |= squareBB(sq);
+            occupied |= squareBB(sq);
+        }
+    if ((pieces[0][PAWN] | pieces[1][PAWN]) & (rowBB(0) | rowBB(7)))
+        throw string("Error parsing FEN: pawn on the first or last rank in \"") + string(placement) + "\"";
+
+    // the side that just moved cannot have left its king in check
+    bool whiteToMove = side == "w";
+    int king = lsb(pieces[!whiteToMove][KING]);
+    const Bitboard* by = pieces[whiteToMove];
+    if ((pawnAttacks[!whiteToMove][king] & by[PAWN])
+        | (knightAttacks[king]           & by[KNIGHT])
+        | (kingAttacks[king]             & by[KING])
+        | (rookAttacks(king, occupied)   & (by[ROOK]   | by[QUEEN]))
+        | (bishopAttacks(king, occupied) & (by[BISHOP] | by[QUEEN])))
+        throw string("Error parsing FEN: the side not to move is in check in \"") + string(fen) + "\"";
+
+    unsigned char newCastling = 0;
+    for (size_t i = 0; rights != "-" && i < rights.length(); i++)
+        switch (rights[i])
+        {
+            case 'K':
+                newCastling |= CASTLE_WHITE_K;
+                break;
+            case 'Q':
+                newCastling |= CASTLE_WHITE_Q;
+                break;
+            case 'k':
+                newCastling |= CASTLE_BLACK_K;
+                break;
+            case 'q':
+                newCastling |= CASTLE_BLACK_Q;
+                break;
+            default:
+                throw string("Error parsing FEN: bad castling \"") + string(rights) + "\"";
+        }
+
+    // a right only stands while the king and that rook are still at home
+    if (!fenHas(types, colours, 4, KING, true))
+        newCastling &= ~(CASTLE_WHITE_K | CASTLE_WHITE_Q);
+    if (!fenHas(types, colours, 7, ROOK, true))
+        newCastling &= ~CASTLE_WHITE_K;
+    if (!fenHas(types, colours, 0, ROOK, true))
+        newCastling &= ~CASTLE_WHITE_Q;
+    if (!fenHas(types, colours, 60, KING, false))
+        newCastling &= ~(CASTLE_BLACK_K | CASTLE_BLACK_Q);
+    if (!fenHas(types, colours, 63, ROOK, false))
+        newCastling &= ~CASTLE_BLACK_K;
+    if (!fenHas(types, colours, 56, ROOK, false))
+        newCastling &= ~CASTLE_BLACK_Q;
+
+    int newEnPassant = -1;
+    if (ep != "-")
+    {
+        if (ep.length() != 2 || ep[0] < 'a' || ep[0] > 'h' || (ep[1] != '3' && ep[1] != '6'))
+            throw string("Error parsing FEN: bad en-passant square \"") + string(ep) + "\"";
+        newEnPassant = (ep[1] - '1') * 8 + (ep[0] - 'a');
+    }
+
+    int halfmove = fenNumber(halfmoveField);
+    int fullmove = fenNumber(fullmoveField);
+    if (halfmove < 0 || fullmove < 0)
+    {
+        halfmove = 0;
+        fullmove = 1;
+    }
+
+    // now replace the board, reusing the pieces already here
+    releasePieces();
+    for (int sq = 0; sq < 64; sq++)
+    {
+        at(sq) = newPiece(types[sq], colours[sq], sq);
+        at(sq)->setLastMove(-1);
+    }
+
+    currentMove = 2 * (fullmove > 0 ? fullmove - 1 : 0) + (whiteToMove ? 0 : 1);
+    castling = newCastling;
+    enPassant = newEnPassant;
+    halfmoveClock = halfmove;
+    moves.clear();
+    rebuildBitboards();
+    assertBoard();
+}
+
+/**************************************************************
+ * BOARD : TO FEN
+ * The FEN record of the position, the inverse of loadFEN.
+ * Written into a buffer on the stack; the only allocation is
+ * the string returned
+ *************************************************************/
+string Board::toFEN() const
+{
+    static const char LETTERS[2][7] = {
+        { ' ', 'k', 'q', 'r', 'b', 'n', 'p' },
+        { ' ', 'K', 'Q', 'R', 'B', 'N', 'P' } };
+
+    // 64 squares and 7 slashes at most, then the other fields
+    char buffer[128];
+    char* p = buffer;
+    for (int row = 7; row >= 0; row--)
+    {
+        int empty = 0;
+        for (int col = 0; col < 8; col++)
+        {
+            const Piece* piece = board[row][col];
+            if (piece->getPieceType() == SPACE)
+                empty++;
+            else
+            {
+                if (empty)
+                    *p++ = (char)('0' + empty);
+                empty = 0;
+                *p++ = LETTERS[piece->getIsWhite()][piece->getPieceType()];
+            }
+        }
+        if (empty)
+            *p++ = (char)('0' + empty);
+        if (row)
+            *p++ = '/';
+    }
+
+    *p++ = ' ';
+    *p++ = whiteTurn() ? 'w' : 'b';
+    *p++ = ' ';
+    if (!castling)
+        *p++ = '-';
+    if (castling & CASTLE_WHITE_K) *p++ = 'K';
+    if (castling & CASTLE_WHITE_Q) *p++ = 'Q';
+    if (castling & CASTLE_BLACK_K) *p++ = 'k';
+    if (castling & CASTLE_BLACK_Q) *p++ = 'q';
+    *p++ = ' ';
+    if (enPassant < 0)
+        *p++ = '-';
+    else
+    {
+        *p++ = (char)('a' + enPassant % 8);
+        *p++ = (char)('1' + enPassant / 8);
+    }
+    p += snprintf(p, buffer + sizeof(buffer) - p, " %d %d", halfmoveClock, currentMove / 2 + 1);
+    return string(buffer, p);
+}
+
+/**************************************************************
+ * BOARD : RELEASE PIECES
+ * Take every piece off the board and out of the undo stack and
+ * keep them in the spares, leaving the squares dangling for
+ * the caller to fill
+ *************************************************************/
+void Board::releasePieces()
+{
+    for (int r = 0; r < 8; r++)
+        for (int c = 0; c < 8; c++)
+            releasePiece(board[r][c]);
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        if (states[i].captured != nullptr)
+            releasePiece(states[i].captured);
+        if (states[i].pawn != nullptr)
+            releasePiece(states[i].pawn);
+    }
+    states.clear();
+}
+
 /**************************************************************
  * BOARD : FREE
  * Free up all the allocated memory
@@ -105,6 +515,21 @@ void Board::free()
     for (int r = 0; r < 8; r++)
         for (int c = 0; c < 8; c++)
             delete board[r][c];
+
+    // the pieces off the board: captured, promoted, and spare
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        delete states[i].captured;
+        delete states[i].pawn;
+    }
+    states.clear();
+    for (int isWhite = 0; isWhite < 2; isWhite++)
+        for (int pt = SPACE; pt <= PAWN; pt++)
+        {
+            for (size_t i = 0; i < spares[isWhite][pt].size(); i++)
+                delete spares[isWhite][pt][i];
+            spares[isWhite][pt].clear();
+        }
 }
 
 /**************************************************************
@@ -117,7 +542,9 @@ void Board::operator -= (const Position& pos)
     if (pos.isInvalid())
         return;
 
-    delete board[pos.getRow()][pos.getCol()];
+    Piece* p = board[pos.getRow()][pos.getCol()];
+    clearBB(pos.getLocation(), p->getPieceType(), p->getIsWhite());
+    delete p;
     board[pos.getRow()][pos.getCol()] = new Space(pos.getRow(), pos.getCol());
 }
 
@@ -132,7 +559,10 @@ void Board::remove(const Position& pos)
     if (pos.isInvalid())
         return;
 
-    delete board[pos.getRow()][pos.getCol()];
+    Piece* p = board[pos.getRow()][pos.getCol()];
+    if (p != NULL)
+        clearBB(pos.getLocation(), p->getPieceType(), p->getIsWhite());
+    delete p;
     board[pos.getRow()][pos.getCol()] = NULL;
 }
 
@@ -143,57 +573,31 @@ void Board::remove(const Position& pos)
  *************************************************************/
 const Piece* Board::operator = (Piece* pPhs)
 {
-    delete board[pPhs->getPosition().getRow()][pPhs->getPosition().getCol()];
-    board[pPhs->getPosition().getRow()][pPhs->getPosition().getCol()] = pPhs;
+    Position pos = pPhs->getPosition();
+    Piece* pOld = board[pos.getRow()][pos.getCol()];
+    if (pOld != NULL)
+        clearBB(pos.getLocation(), pOld->getPieceType(), pOld->getIsWhite());
+    delete pOld;
+    board[pos.getRow()][pos.getCol()] = pPhs;
+    placeBB(pos.getLocation(), pPhs->getPieceType(), pPhs->getIsWhite());
     return pPhs;
 }
 
 /**************************************************************
  * BOARD UNDO
- * Back up one move. This is done by fetching the
- * last move off the move list and executing it
- * backwards
+ * Back up one move. Only the last move made can be taken back
  *************************************************************/
 void Board::operator -= (const Move& move)
 {
-    Position src = move.getSrc();
-    Position des = move.getDes();
-
-    // Castle king side
-    if (move.getCastleK())
-    {
-        assert(false);
-    }
-
-    // Castle queen side
-    else if (move.getCastleQ())
-    {
-        assert(false);
-    }
-
-    // en-passant
-    else if (move.getEnPassant())
-    {
-        assert(false);
-    }
-
-    // promotion
-    else if (move.getPromotion() != SPACE)
-    {
-        assert(false);
-    }
-
-    // capture?
-    else if (move.getCapture() != SPACE)
+    if (states.empty() || states.back().move != PackedMove(move))
     {
         assert(false);
+        return;
     }
 
-    // standard move
-    else
-    {
-        swap(src, des);
-    }
+    unmakeMove();
+    if (!moves.empty())
+        moves.pop_back();
 }
 
 /**************************************************************
@@ -212,9 +616,244 @@ void Board::assertBoard()
         }
 
     assert(currentMove >= 0);
+    assert((bbColour[0] | bbColour[1]) == bbOccupied);
+    assert((bbColour[0] & bbColour[1]) == BB_EMPTY);
+    assert(key == computeKey());
 #endif // NDEBUG
 }
 
+/**************************************************************
+ * BOARD : PLACE BB
+ * Add a piece to the bitboards
+ * INPUT sq       The square the piece now occupies
+ *       pt       What type of piece it is
+ *       isWhite  Which side it belongs to
+ *************************************************************/
+void Board::placeBB(int sq, PieceType pt, bool isWhite)
+{
+    if (pt == SPACE)
+        return;
+
+    Bitboard bb = squareBB(sq);
+    bbPieces[isWhite][pt] |= bb;
+    bbColour[isWhite] |= bb;
+    bbOccupied |= bb;
+    key ^= zobristPieces[isWhite][pt][sq];
+    psqMgTotal += psqMg[isWhite][pt][sq];
+    psqEgTotal += psqEg[isWhite][pt][sq];
+    phase += PHASE_WEIGHT[pt];
+    if (nnueNetwork)
+        nnueAdd(accumulator, pt, isWhite, sq);
+}
+
+/**************************************************************
+ * BOARD : CLEAR BB
+ * Remove a piece from the bitboards
+ * INPUT sq       The square the piece is leaving
+ *       pt       What type of piece it is
+ *       isWhite  Which side it belongs to
+ *************************************************************/
+void Board::clearBB(int sq, PieceType pt, bool isWhite)
+{
+    if (pt == SPACE)
+        return;
+
+    Bitboard bb = ~squareBB(sq);
+    bbPieces[isWhite][pt] &= bb;
+    bbColour[isWhite] &= bb;
+    bbOccupied &= bb;
+    key ^= zobristPieces[isWhite][pt][sq];
+    psqMgTotal -= psqMg[isWhite][pt][sq];
+    psqEgTotal -= psqEg[isWhite][pt][sq];
+    phase -= PHASE_WEIGHT[pt];
+    if (nnueNetwork)
+        nnueRemove(accumulator, pt, isWhite, sq);
+}
+
+/**************************************************************
+ * BOARD : ATTACKERS TO
+ * Every piece of one side attacking a square. Rather than
+ * generating that side's moves, look outward from the square
+ * with each kind of piece's attack pattern: whatever of that
+ * kind it reaches is attacking it.
+ * INPUT sq        The square being attacked
+ *       byWhite   The side doing the attacking
+ *       occupied  The blockers for the sliders; pass something other
+ *                 than getOccupied() to ask "what if" questions
+ *************************************************************/
+Bitboard Board::attackersTo(int sq, bool byWhite, Bitboard occupied) const
+{
+    const Bitboard* pieces = bbPieces[byWhite];
+    return (pawnAttacks[!byWhite][sq]   & pieces[PAWN])
+         | (knightAttacks[sq]           & pieces[KNIGHT])
+         | (kingAttacks[sq]             & pieces[KING])
+         | (rookAttacks(sq, occupied)   & (pieces[ROOK]   | pieces[QUEEN]))
+         | (bishopAttacks(sq, occupied) & (pieces[BISHOP] | pieces[QUEEN]));
+}
+
+/**************************************************************
+ * BOARD : IS SQUARE ATTACKED
+ * Does one side attack a square? Stops at the first kind of
+ * piece found, cheapest lookups first
+ *************************************************************/
+bool Board::isSquareAttacked(int sq, bool byWhite) const
+{
+    const Bitboard* pieces = bbPieces[byWhite];
+    return (pawnAttacks[!byWhite][sq] & pieces[PAWN])
+        || (knightAttacks[sq] & pieces[KNIGHT])
+        || (kingAttacks[sq] & pieces[KING])
+        || (rookAttacks(sq, bbOccupied)   & (pieces[ROOK]   | pieces[QUEEN]))
+        || (bishopAttacks(sq, bbOccupied) & (pieces[BISHOP] | pieces[QUEEN]));
+}
+
+/**************************************************************
+ * BOARD : SEE
+ * Static exchange evaluation: the material the side to move
+ * gains by making a capture when both sides keep recapturing
+ * on that square with their least valuable piece, and either
+ * may stop when going on would lose. Nothing is moved; the
+ * capturers are taken out of a copy of the occupancy, which
+ * uncovers the sliders lined up behind them (x-rays).
+ * Pins are ignored.
+ * INPUT  move    A move of the side to move
+ * OUTPUT return  The gain in centipawns, negative if it loses
+ *************************************************************/
+int Board::see(PackedMove move) const
+{
+    static const PieceType ORDER[6] = { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+    int src = move.getSrc();
+    int des = move.getDes();
+    bool side = whiteTurn();
+
+    // the first capture, which may promote
+    int gain[32];
+    PieceType onSquare = pieceOn(src);
+    gain[0] = move.isEnPassant() ? PIECE_VALUES[PAWN] : PIECE_VALUES[pieceOn(des)];
+    if (move.isPromotion())
+    {
+        onSquare = move.getPromotion();
+        gain[0] += PIECE_VALUES[onSquare] - PIECE_VALUES[PAWN];
+    }
+
+    Bitboard occupied = bbOccupied ^ squareBB(src);
+    if (move.isEnPassant())
+        occupied ^= squareBB(des + (side ? -8 : 8));
+    Bitboard attackers = (attackersTo(des, true, occupied) | attackersTo(des, false, occupied)) & occupied;
+    Bitboard diagonal = bbPieces[0][BISHOP] | bbPieces[1][BISHOP] | bbPieces[0][QUEEN] | bbPieces[1][QUEEN];
+    Bitboard straight = bbPieces[0][ROOK]   | bbPieces[1][ROOK]   | bbPieces[0][QUEEN] | bbPieces[1][QUEEN];
+
+    int depth = 0;
+    for (side = !side; ; side = !side)
+    {
+        Bitboard mine = attackers & bbColour[side];
+        if (!mine)
+            break;
+
+        // the least valuable recapture
+        PieceType pt = KING;
+        Bitboard from = 0;
+        for (int i = 0; i < 6; i++)
+            if ((from = mine & bbPieces[side][ORDER[i]]))
+            {
+                pt = ORDER[i];
+                break;
+            }
+
+        // the king may not take a defended piece
+        if (pt == KING && (attackers & bbColour[!side]))
+            break;
+
+        depth++;
+        gain[depth] = PIECE_VALUES[onSquare] - gain[depth - 1];
+        onSquare = pt;
+
+        occupied ^= from & (0 - from);
+        if (pt == PAWN || pt == BISHOP || pt == QUEEN)
+            attackers |= bishopAttacks(des, occupied) & diagonal;
+        if (pt == ROOK || pt == QUEEN)
+            attackers |= rookAttacks(des, occupied) & straight;
+        attackers &= occupied;
+    }
+
+    // either side may decline to recapture
+    while (depth > 0)
+    {
+        depth--;
+        if (-gain[depth + 1] < gain[depth])
+            gain[depth] = -gain[depth + 1];
+    }
+    return gain[0];
+}
+
+/**************************************************************
+ * BOARD : IS DRAW
+ * Fifty moves without a capture or pawn move, or a position
+ * seen before with the same side to move. A search treats the
+ * first repetition as a draw since the side that allowed it
+ * could repeat again.
+ *************************************************************/
+bool Board::isDraw() const
+{
+    if (halfmoveClock >= 100)
+        return true;
+
+    // only positions since the last irreversible move can repeat
+    int size = (int)states.size();
+    for (int ply = 4; ply <= halfmoveClock && ply <= size; ply += 2)
+        if (states[size - ply].key == key)
+            return true;
+    return false;
+}
+
+/**************************************************************
+ * BOARD : COMPUTE KEY
+ * Hash the position from scratch. The board keeps its key up
+ * to date as it changes, so this is for verifying that key
+ *************************************************************/
+Key Board::computeKey() const
+{
+    Key k = 0;
+    for (int isWhite = 0; isWhite < 2; isWhite++)
+        for (int pt = KING; pt <= PAWN; pt++)
+        {
+            Bitboard pieces = bbPieces[isWhite][pt];
+            while (pieces)
+                k ^= zobristPieces[isWhite][pt][popLsb(pieces)];
+        }
+
+    if (!whiteTurn())
+        k ^= zobristBlack;
+    k ^= zobristCastling[castling];
+    if (enPassant >= 0)
+        k ^= zobristEnPassant[enPassant % 8];
+    return k;
+}
+
+/**************************************************************
+ * BOARD : REBUILD BITBOARDS
+ * Recompute every bitboard, the key, the piece-square sums and
+ * the network accumulator from the pieces on the board. Only
+ * needed when the whole board is replaced; everything else
+ * keeps them in sync one square at a time
+ *************************************************************/
+void Board::rebuildBitboards()
+{
+    for (int isWhite = 0; isWhite < 2; isWhite++)
+    {
+        bbColour[isWhite] = BB_EMPTY;
+        for (int pt = SPACE; pt <= PAWN; pt++)
+            bbPieces[isWhite][pt] = BB_EMPTY;
+    }
+    bbOccupied = BB_EMPTY;
+    psqMgTotal = psqEgTotal = phase = 0;
+
+    for (int r = 0; r < 8; r++)
+        for (int c = 0; c < 8; c++)
+            placeBB(r * 8 + c, board[r][c]->getPieceType(), board[r][c]->getIsWhite());
+    key = computeKey();
+    refreshAccumulator();
+}
+
 /**************************************************************
  * BOARD : SWAP
  * Swap two pieces on the board
@@ -227,6 +866,14 @@ void Board::swap(const Position& pos1, const Position& pos2)
     assert(pos1.isValid());
     assert(pos2.isValid());
 
+    // move both pieces in the bitboards
+    Piece* p1 = board[pos1.getRow()][pos1.getCol()];
+    Piece* p2 = board[pos2.getRow()][pos2.getCol()];
+    clearBB(pos1.getLocation(), p1->getPieceType(), p1->getIsWhite());
+    clearBB(pos2.getLocation(), p2->getPieceType(), p2->getIsWhite());
+    placeBB(pos1.getLocation(), p2->getPieceType(), p2->getIsWhite());
+    placeBB(pos2.getLocation(), p1->getPieceType(), p1->getIsWhite());
+
     // perform the swap from the board's perspective
     Piece* p = board[pos1.getRow()][pos1.getCol()];
     board[pos1.getRow()][pos1.getCol()] = board[pos2.getRow()][pos2.getCol()];
@@ -252,166 +899,296 @@ void Board::swap(const Position& pos1, const Position& pos2)
  *************************************************************/
 bool Board::move(const Move& move)
 {
-    bool moveOccurred = false;
-
     Position src = move.getSrc();
     Position des = move.getDes();
 
-    assert(board[src.getRow()][src.getCol()]->getLetter() != ' ');
     assert(src.isValid());
     assert(des.isValid());
 
+    // Nothing there to move
+    if (board[src.getRow()][src.getCol()]->getPieceType() == SPACE)
+        return false;
+
     // Not your turn
     if (whiteTurn() != board[src.getRow()][src.getCol()]->getIsWhite()) {
         return false;
     }
 
-    // Destination occupied 
-    if (move.getCapture() != SPACE 
-        && board[des.getRow()][des.getCol()]->getIsWhite() == board[src.getRow()][src.getCol()]->getIsWhite() 
-        && !move.getCastleK() && !move.getCastleQ()) 
-    {
+    // Only a legal move with the same squares and promotion
+    MoveList legal;
+    generateLegalMoves(*this, legal);
+    PackedMove packed;
+    for (PackedMove candidate : legal)
+        if (candidate.getSrc() == src.getLocation() && candidate.getDes() == des.getLocation()
+            && candidate.getPromotion() == move.getPromotion())
+            packed = candidate;
+    if (packed.isNull())
         return false;
-    }
 
-    // Castle King side
-    if (move.getCastleK())
-    {
-        int row = (move.getWhiteMove() ? 7 : 0);
-
-        // move the king
-        src.set(row, 6);
-        des.set(row, 4);
-        swap(src, des);
-
-        // move the rook
-        src.set(row, 5);
-        des.set(row, 7);
-        swap(src, des);
-        
-        // DEBUG 
-        cout << "King Side Castle" << endl;
-
-        moveOccurred = true;
-    }
+    makeMove(packed);
+    addMove(move);
 
-    // Castle Queen side
-    else if (move.getCastleQ())
+    assertBoard();
+    return true;
+}
+
+/**************************************************************
+ * BOARD : MAKE MOVE
+ * Play a move, pushing what it destroys onto the undo stack
+ * so unmakeMove can put it back. Pieces leaving the board are
+ * kept, and new ones come from the spares, so in play this
+ * does not allocate.
+ * INPUT move  The move to make, generated from this position
+ *************************************************************/
+void Board::makeMove(PackedMove move)
+{
+    // rights lost when a piece leaves or lands on each square
+    static const unsigned char CASTLING_KEPT[64] = {
+        (unsigned char)~CASTLE_WHITE_Q, 15, 15, 15, (unsigned char)~(CASTLE_WHITE_K | CASTLE_WHITE_Q), 15, 15, (unsigned char)~CASTLE_WHITE_K,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        (unsigned char)~CASTLE_BLACK_Q, 15, 15, 15, (unsigned char)~(CASTLE_BLACK_K | CASTLE_BLACK_Q), 15, 15, (unsigned char)~CASTLE_BLACK_K
+    };
+
+    int src = move.getSrc();
+    int des = move.getDes();
+    Piece* mover = at(src);
+    PieceType pt = mover->getPieceType();
+
+    BoardState state;
+    state.move = move;
+    state.captured = nullptr;
+    state.pawn = nullptr;
+    state.lastMove = mover->getLastMove();
+    state.rookLastMove = -1;
+    state.enPassant = enPassant;
+    state.halfmoveClock = halfmoveClock;
+    state.castling = castling;
+    state.key = key;
+
+    halfmoveClock++;
+    if (enPassant >= 0)
+        key ^= zobristEnPassant[enPassant % 8];
+    enPassant = -1;
+
+    if (move.isCastle())
     {
-        int row = (move.getWhiteMove() ? 7 : 0);
-
-        // move the king
-        src.set(row, 2);
-        des.set(row, 4);
-        swap(src, des);
-
-        // move the rook
-        src.set(row, 3);
-        des.set(row, 0);
-        swap(src, des);
-
-        // DEBUG 
-        cout << "Queen Side Castle" << endl;
-        
-        moveOccurred = true;
+        // the rook jumps over the king from the corner
+        int rookSrc = (move.getFlag() == MOVE_CASTLE_K) ? src + 3 : src - 4;
+        int rookDes = (move.getFlag() == MOVE_CASTLE_K) ? src + 1 : src - 1;
+        state.rookLastMove = at(rookSrc)->getLastMove();
+        movePiece(src, des);
+        movePiece(rookSrc, rookDes);
     }
-
-    // en-passant
-    else if (!moves.empty() && move.getEnPassant())
+    else
     {
-        // Get the position of the captured pawn
-        Position capturedPawnPos = moves.back().getDes();
-
-        // Remove the captured pawn from the board
-        *this -= capturedPawnPos;
+        // take the captured piece off the board
+        int capSq = move.isEnPassant() ? (src / 8) * 8 + des % 8 : des;
+        if (bbOccupied & squareBB(capSq))
+        {
+            state.captured = takePiece(capSq);
+            halfmoveClock = 0;
+        }
 
-        // Move your pawn to the destination square
-        swap(src, des);
+        movePiece(src, des);
 
-        // DEBUG 
-        cout << "En-passant" << endl;
-        
-        moveOccurred = true;
+        if (pt == PAWN)
+        {
+            halfmoveClock = 0;
+
+            // a double push lets the opponent capture en-passant behind it
+            if (des - src == 16 || src - des == 16)
+                enPassant = (src + des) / 2;
+
+            // swap the pawn for the promoted piece
+            if (move.isPromotion())
+            {
+                state.pawn = takePiece(des);
+                putPiece(des, newPiece(move.getPromotion(), mover->getIsWhite(), des));
+            }
+        }
     }
 
-    // promotion?
-    else if (move.getPromotion() != SPACE) {
-        // Replace pawn with new piece at destination based on promotion
-        Position dest = move.getDes();
-        bool isWhite = move.getWhiteMove();
-        Piece* promotedPiece = nullptr;
+    key ^= zobristCastling[castling];
+    castling &= CASTLING_KEPT[src] & CASTLING_KEPT[des];
+    key ^= zobristCastling[castling];
+    if (enPassant >= 0)
+        key ^= zobristEnPassant[enPassant % 8];
+    key ^= zobristBlack;
 
-        switch (move.getPromotion()) {
-        case QUEEN:
-            promotedPiece = new Queen(dest.getRow(), dest.getCol(), isWhite);
-            break;
-        case ROOK:
-            promotedPiece = new Rook(dest.getRow(), dest.getCol(), isWhite);
-            break;
-        case BISHOP:
-            promotedPiece = new Bishop(dest.getRow(), dest.getCol(), isWhite);
-            break;
-        case KNIGHT:
-            promotedPiece = new Knight(dest.getRow(), dest.getCol(), isWhite);
-            break;
-        default:
-            assert(false);
-            break;
-        }
+    states.push_back(state);
+    currentMove++;
+}
+
+/**************************************************************
+ * BOARD : UNMAKE MOVE
+ * Take back the last move made with makeMove, restoring the
+ * board exactly as it was
+ *************************************************************/
+void Board::unmakeMove()
+{
+    assert(!states.empty());
+    const BoardState& state = states.back();
+    PackedMove move = state.move;
+    int src = move.getSrc();
+    int des = move.getDes();
 
-        if (promotedPiece != nullptr) {
-            // Assuming board is a 2D array of Piece pointers
-            Position posKill(src.getRow(), des.getCol());
-            *this -= posKill;            
-            board[dest.getRow()][dest.getCol()] = promotedPiece; // Place the new piece
+    currentMove--;
+
+    if (move.isCastle())
+    {
+        int rookSrc = (move.getFlag() == MOVE_CASTLE_K) ? src + 3 : src - 4;
+        int rookDes = (move.getFlag() == MOVE_CASTLE_K) ? src + 1 : src - 1;
+        movePiece(rookDes, rookSrc);
+        movePiece(des, src);
+        at(rookSrc)->setLastMove(state.rookLastMove);
+    }
+    else
+    {
+        // swap the promoted piece back for the pawn
+        if (state.pawn != nullptr)
+        {
+            releasePiece(takePiece(des));
+            putPiece(des, state.pawn);
         }
-        
-        // DEBUG 
-        cout << "Promotion" << endl;
 
-        moveOccurred = true;
+        movePiece(des, src);
+
+        // and return the captured piece to its square
+        if (state.captured != nullptr)
+            putPiece(move.isEnPassant() ? (src / 8) * 8 + des % 8 : des, state.captured);
     }
 
-    // capture?
-    else if (move.getCapture() != SPACE)
-    {
-        assert(board[des.getRow()][des.getCol()]->getLetter() != ' ');
-        assert(board[src.getRow()][src.getCol()]->getLetter() != ' ');
-        assert(board[src.getRow()][src.getCol()]->getIsWhite() == move.getWhiteMove());
-        assert(board[des.getRow()][des.getCol()]->getIsWhite() != move.getWhiteMove());
+    at(src)->setLastMove(state.lastMove);
+    enPassant = state.enPassant;
+    halfmoveClock = state.halfmoveClock;
+    castling = state.castling;
+    key = state.key;
+    states.pop_back();
+}
 
-        // delete the piece
-        *this -= des;
+/**************************************************************
+ * BOARD : MAKE NULL MOVE
+ * Pass the turn without moving, for the search to see what
+ * the opponent could do with two moves in a row. Any chance
+ * to capture en-passant is lost. The halfmove clock restarts
+ * so no repetition is found across the pass.
+ *************************************************************/
+void Board::makeNullMove()
+{
+    BoardState state;
+    state.move = PackedMove();
+    state.captured = nullptr;
+    state.pawn = nullptr;
+    state.lastMove = -1;
+    state.rookLastMove = -1;
+    state.enPassant = enPassant;
+    state.halfmoveClock = halfmoveClock;
+    state.castling = castling;
+    state.key = key;
+
+    if (enPassant >= 0)
+        key ^= zobristEnPassant[enPassant % 8];
+    enPassant = -1;
+    halfmoveClock = 0;
+    key ^= zobristBlack;
+
+    states.push_back(state);
+    currentMove++;
+}
 
-        // swap the piece
-        swap(src, des);
-        
-        // DEBUG 
-        cout << "Capture" << endl;
+/**************************************************************
+ * BOARD : UNMAKE NULL MOVE
+ * Take back the pass made with makeNullMove
+ *************************************************************/
+void Board::unmakeNullMove()
+{
+    assert(!states.empty() && states.back().move.isNull());
+    const BoardState& state = states.back();
+    enPassant = state.enPassant;
+    halfmoveClock = state.halfmoveClock;
+    key = state.key;
+    states.pop_back();
+    currentMove--;
+}
 
-        moveOccurred = true;
-    }
+/**************************************************************
+ * BOARD : MOVE PIECE
+ * Move a piece onto an empty square, the empty square taking
+ * its place
+ * INPUT src   Where the piece is
+ *       des   The empty square it is moving to
+ *************************************************************/
+void Board::movePiece(int src, int des)
+{
+    Piece* p = at(src);
+    Piece* space = at(des);
+    assert(space->getPieceType() == SPACE);
+
+    clearBB(src, p->getPieceType(), p->getIsWhite());
+    placeBB(des, p->getPieceType(), p->getIsWhite());
+
+    at(des) = p;
+    at(src) = space;
+    *p = Position(des);
+    *space = Position(src);
+    p->setLastMove(currentMove);
+}
 
-    // otherwise, a normal piecemove
-    else
-    {
-        assert(board[des.getRow()][des.getCol()]->getLetter() == ' ');
-        assert(board[src.getRow()][src.getCol()]->getLetter() != ' ');
-        assert(board[src.getRow()][src.getCol()]->getIsWhite() == move.getWhiteMove());
-
-        // swap the piece
-        swap(src, des);
-        
-        moveOccurred = true;
-    }
+/**************************************************************
+ * BOARD : TAKE PIECE
+ * Lift a piece off the board, leaving an empty square
+ * INPUT  sq   The square of the piece
+ * OUTPUT      The piece, which the caller now owns
+ *************************************************************/
+Piece* Board::takePiece(int sq)
+{
+    Piece* p = at(sq);
+    clearBB(sq, p->getPieceType(), p->getIsWhite());
+    at(sq) = newPiece(SPACE, false, sq);
+    return p;
+}
 
-    assertBoard();
+/**************************************************************
+ * BOARD : PUT PIECE
+ * Place a piece on an empty square
+ * INPUT  sq   The empty square
+ *        p    The piece, which the board now owns
+ *************************************************************/
+void Board::putPiece(int sq, Piece* p)
+{
+    assert(at(sq)->getPieceType() == SPACE);
+    releasePiece(at(sq));
+    at(sq) = p;
+    *p = Position(sq);
+    placeBB(sq, p->getPieceType(), p->getIsWhite());
+}
 
-    // advance by one move
-    if (moveOccurred) {
-        currentMove++;
-        addMove(move);
-    }
+/**************************************************************
+ * BOARD : NEW PIECE
+ * A piece from the spares, only allocating when there are none
+ *************************************************************/
+Piece* Board::newPiece(PieceType pt, bool isWhite, int sq)
+{
+    vector<Piece*>& spare = spares[pt == SPACE ? false : isWhite][pt];
+    if (spare.empty())
+        return pieceFactory(pt, sq / 8, sq % 8, isWhite);
+
+    Piece* p = spare.back();
+    spare.pop_back();
+    *p = Position(sq);
+    return p;
+}
 
-    return moveOccurred;
+/**************************************************************
+ * BOARD : RELEASE PIECE
+ * Keep a piece that left the board for reuse
+ *************************************************************/
+void Board::releasePiece(Piece* p)
+{
+    spares[p->getPieceType() == SPACE ? false : p->getIsWhite()][p->getPieceType()].push_back(p);
 }
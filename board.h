@@ -7,13 +7,19 @@
 
 #pragma once
 
-#include "position.h" // for POSITION: how we locate pieces
-#include "piece.h"    // for PIECE: what the board consists of
-#include "move.h"     // for MOVE: how we move pieces around
-#include "uiDraw.h"
-#include "uiInteract.h"
+#include "position.h"   // for POSITION: how we locate pieces
+#include "piece.h"      // for PIECE: what the board consists of
+#include "move.h"       // for MOVE: how we move pieces around
+#include "moveList.h"   // for MOVELIST: the moves of one position
+#include "packedMove.h" // for PACKEDMOVE: the undo stack
+#include "bitboard.h"   // for BITBOARD: sets of squares
+#include "zobrist.h"    // for KEY: the position hash
+#include "psqt.h"       // for PSQT: the piece-square evaluation
+#include "nnue.h"       // for ACCUMULATOR: the network evaluation
 #include <iostream>
 #include <set>
+#include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
@@ -31,6 +37,35 @@ namespace Lab06UnitTest
 
 class Piece; // Forward declaration
 
+// CASTLING RIGHT
+// One bit for each castle that is still allowed
+enum CastlingRight
+{
+	CASTLE_WHITE_K = 1,
+	CASTLE_WHITE_Q = 2,
+	CASTLE_BLACK_K = 4,
+	CASTLE_BLACK_Q = 8,
+	CASTLE_ALL     = 15
+};
+
+// deepest a game plus a search reaches before the undo stack grows
+const int MAX_PLY = 1024;
+
+// BOARD STATE
+// Everything a move destroys that unmakeMove needs back
+struct BoardState
+{
+	PackedMove move;        // the move that was made
+	Piece* captured;        // the piece it captured, now off the board
+	Piece* pawn;            // the pawn it promoted, now off the board
+	int lastMove;           // when the moving piece had last moved
+	int rookLastMove;       // same for the rook of a castle
+	int enPassant;          // the en-passant square before the move
+	int halfmoveClock;      // moves since a capture or pawn move, before the move
+	unsigned char castling; // the castling rights before the move
+	Key key;                // the position hash before the move
+};
+
 // BOARD
 // The game board
 class Board
@@ -45,24 +80,56 @@ public:
 	friend Lab06UnitTest::TestQueen;
 
 	// create and destroy the board
-	Board(ogstream* pgout = nullptr, bool noReset = false);
+	Board(bool noReset = false);
+	Board(const Board& rhs);
 	~Board();
+	Board& operator = (const Board& rhs);
 
 	// getters
 	int getCurrentMove() const { return currentMove;		   }
-	bool whiteTurn() const { return getCurrentMove() % 2 == 1; }
-	void display(const Position source, const Interface& ui, const set<Move>& possible) const;
+	bool whiteTurn() const { return getCurrentMove() % 2 == 0; }
 	const Piece& operator [] (const Position& pos) const
 	{
 		return *board[pos.getRow()][pos.getCol()];
 	}
 	Move getLastMove() const { return moves.back(); }
+	PieceType pieceOn(int sq) const;
+	PackedMove getPreviousMove() const { return states.empty() ? PackedMove() : states.back().move; }
+	unsigned char getCastling() const { return castling;      }
+	int getEnPassant() const          { return enPassant;     }
+	int getHalfmoveClock() const      { return halfmoveClock; }
+	bool isDraw() const;
+	Key getKey() const                { return key;           }
+	string toFEN() const;
+	Key computeKey() const;
+	int getPsqMg() const { return psqMgTotal; }
+	int getPsqEg() const { return psqEgTotal; }
+	int getPhase() const { return phase;      }
+	const Accumulator& getAccumulator() const { return accumulator; }
+	void generateMoves(MoveList& list) const;
 	vector<Move> getMoveHistory() const { return moves; }
 
+	// bitboards: the same board as sets of squares
+	Bitboard getOccupied() const                         { return bbOccupied;                        }
+	Bitboard getColour(bool isWhite) const               { return bbColour[isWhite];                 }
+	Bitboard getPieces(bool isWhite, PieceType pt) const { return bbPieces[isWhite][pt];             }
+	Bitboard getPieces(PieceType pt) const               { return bbPieces[0][pt] | bbPieces[1][pt]; }
+	Bitboard attackersTo(int sq, bool byWhite) const { return attackersTo(sq, byWhite, bbOccupied); }
+	Bitboard attackersTo(int sq, bool byWhite, Bitboard occupied) const;
+	bool isSquareAttacked(int sq, bool byWhite) const;
+	bool inCheck() const { return isSquareAttacked(lsb(bbPieces[whiteTurn()][KING]), !whiteTurn()); }
+	int see(PackedMove move) const;
+	int see(const Move& move) const { return see(PackedMove(move)); }
+
 	// setters
 	void free();
 	virtual void reset(bool fFree = true);
+	void loadFEN(string_view fen);
 	bool move(const Move& move);
+	void makeMove(PackedMove move);
+	void unmakeMove();
+	void makeNullMove();
+	void unmakeNullMove();
 	void operator -= (const Position& pos);
 	void operator -= (const Move& move);
 	void remove(const Position& pos);
@@ -72,16 +139,47 @@ public:
 		return *board[pos.getRow()][pos.getCol()];
 	}
 	void swap(const Position& pos1, const Position& pos2);
-	void setCurrentMove(int currentMove) { this->currentMove = currentMove; }
+	void refreshAccumulator() { if (nnueNetwork) nnueRefresh(accumulator, *this); }
+	void setCurrentMove(int currentMove)
+	{
+		if ((this->currentMove - currentMove) % 2 != 0)
+			key ^= zobristBlack;
+		this->currentMove = currentMove;
+	}
 	static Piece* pawnFactory(int row, int col, bool isWhite);
+	static Piece* pieceFactory(PieceType pt, int row, int col, bool isWhite);
 	void addMove(const Move& move) { moves.push_back(move);	}
 
 protected:
 	void assertBoard();
+	void copy(const Board& rhs);
+	Piece* clonePiece(const Piece* p);
+	void releasePieces();
+	void placeBB(int sq, PieceType pt, bool isWhite);
+	void clearBB(int sq, PieceType pt, bool isWhite);
+	void rebuildBitboards();
+	Piece*& at(int sq) { return board[sq / 8][sq % 8]; }
+	void movePiece(int src, int des);
+	Piece* takePiece(int sq);
+	void putPiece(int sq, Piece* p);
+	Piece* newPiece(PieceType pt, bool isWhite, int sq);
+	void releasePiece(Piece* p);
 
 	Piece* board[8][8]; // the board of chess pieces
 	int currentMove;    // the current move number we are on
-	ogstream* pgout;     // the output stream
+	Bitboard bbPieces[2][7]; // squares of each piece type, indexed by [isWhite][PieceType]
+	Bitboard bbColour[2];    // squares of each colour, indexed by [isWhite]
+	Bitboard bbOccupied;     // every square holding a piece
+	unsigned char castling;  // the CastlingRights still available
+	int enPassant;           // square a pawn may capture en-passant onto, -1 if none
+	int halfmoveClock;       // moves since the last capture or pawn move
+	Key key;                 // Zobrist hash, updated with every change to the board
+	int psqMgTotal;          // piece-square sums, white minus black, kept like the key
+	int psqEgTotal;
+	int phase;               // PHASE_WEIGHT of every piece on the board
+	Accumulator accumulator; // network first layer, kept only while a network is loaded
+	vector<BoardState> states;   // undo stack, one entry per move made
+	vector<Piece*> spares[2][7]; // pieces off the board ready for reuse, by [isWhite][PieceType]
 	vector<Move> moves;
 };
 
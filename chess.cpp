@@ -10,12 +10,75 @@
 #include "board.h"
 #include "position.h"
 #include "move.h"
+#include "movegen.h"
 
 using namespace std;
 
+/**************************************************************
+ * DISPLAY
+ * Draw the board, the hover and selected squares, the possible
+ * moves and then the pieces. The rules code knows nothing of
+ * drawing, so the pieces are drawn by their type here
+ *************************************************************/
+static void display(ogstream& gout, const Board& board, const Interface& ui, const set<Move>& possible)
+{
+    // draw the base board
+    gout.drawBoard();
+
+    // draw the hover and select stuff
+    gout.drawHover(ui.getHoverPosition());
+    gout.drawSelected(ui.getSelectPosition());
+
+    // draw the possible moves
+    set<Move> ::iterator it;
+    for (it = possible.begin(); it != possible.end(); ++it)
+        gout.drawPossible(it->getDes().getLocation());
+
+    // draw the pieces
+    for (int sq = 0; sq < 64; sq++)
+    {
+        const Piece& piece = board[Position(sq)];
+        bool black = !piece.getIsWhite();
+        switch (piece.getPieceType())
+        {
+        case KING:
+            gout.drawKing(sq, black);
+            break;
+        case QUEEN:
+            gout.drawQueen(sq, black);
+            break;
+        case ROOK:
+            gout.drawRook(sq, black);
+            break;
+        case BISHOP:
+            gout.drawBishop(sq, black);
+            break;
+        case KNIGHT:
+            gout.drawKnight(sq, black);
+            break;
+        case PAWN:
+            gout.drawPawn(sq, black);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**************************************************************
+ * GAME
+ * What the callback needs: the board and where to draw it
+ *************************************************************/
+struct Game
+{
+    Board board;
+    ogstream gout;
+};
+
 void callBack(Interface* pUI, void* p)
 {
-    Board* board = (Board*)p;
+    Game* game = (Game*)p;
+    Board* board = &game->board;
     set<Move> possible;
 
     Position source = pUI->getPreviousPosition();
@@ -27,7 +90,12 @@ void callBack(Interface* pUI, void* p)
         pUI->clearSelectPosition(); 
     }
     else if (destination.getLocation() != -1) {
-        (*board)[destination].getMoves(possible, *board);
+        // highlight the legal moves of the selected piece
+        MoveList legal;
+        generateLegalMoves(*board, legal);
+        for (PackedMove move : legal)
+            if (move.getSrc() == destination.getLocation())
+                possible.insert(move.toMove(*board));
     }
 
     // if we clicked on a blank spot, unselect it
@@ -36,18 +104,17 @@ void callBack(Interface* pUI, void* p)
     }
 
     // draw the game
-    board->display(source, *pUI, possible);
+    display(game->gout, *board, *pUI, possible);
 }
 
 int main(int argc, char** argv)
 {
     Interface ui("Chess");
-    ogstream pgout;
 
-    Board board(&pgout);
-    board.reset(true);
+    Game game;
+    game.board.reset(true);
 
-    ui.run(callBack, &board);
+    ui.run(callBack, &game);
 
     return 0;
 }
@@ -0,0 +1,26 @@
+/***********************************************************************
+ * Source File:
+ *    EVALUATE : How good a position is
+ * Summary:
+ *    Material and piece placement, from the piece-square sums the Board
+ *    keeps up to date, so evaluating costs the same however many pieces
+ *    there are. The middlegame and endgame sums are blended by how much
+ *    material is left. When a network is loaded it is used instead.
+ ************************************************************************/
+
+#include "eval.h"
+#define NDEBUG
+#include <cassert>
+
+/***************************************************
+ * EVALUATE
+ ***************************************************/
+int evaluate(const Board& board)
+{
+   if (nnueNetwork)
+      return nnueEvaluate(board);
+
+   int phase = board.getPhase() < PHASE_MAX ? board.getPhase() : PHASE_MAX;
+   int score = (board.getPsqMg() * phase + board.getPsqEg() * (PHASE_MAX - phase)) / PHASE_MAX;
+   return board.whiteTurn() ? score : -score;
+}
@@ -0,0 +1,17 @@
+/***********************************************************************
+ * Header File:
+ *    EVALUATE : How good a position is
+ * Summary:
+ *    A static estimate of a position in centipawns, from the point of
+ *    view of the side to move. Positive means the side to move is
+ *    better off.
+ ************************************************************************/
+
+#pragma once
+
+#include "board.h"
+
+// the worth of each piece, indexed by PieceType
+const int PIECE_VALUES[7] = { 0, 0, 900, 500, 330, 320, 100 };
+
+int evaluate(const Board& board);
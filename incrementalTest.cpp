@@ -0,0 +1,129 @@
+/**********************************************************************
+ * INCREMENTAL TEST
+ * The board keeps some of its state up to date a square at a time
+ * as moves are made and taken back: the Zobrist key, the
+ * piece-square sums, the game phase and the network accumulator.
+ * Walk the perft trees of the reference positions, with a random
+ * network loaded, and compare that state with the same thing
+ * computed from scratch after every makeMove and every unmakeMove.
+ * Exits non-zero after reporting the first failures
+ **********************************************************************/
+
+#include "board.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "perft.h"
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+static const int DEPTH = 3;
+static const int MAX_REPORTS = 10;
+
+/***************************************************
+ * RANDOM NETWORK
+ * Weights with no meaning, small enough that the
+ * accumulator cannot overflow
+ ***************************************************/
+static void randomNetwork(Network& net)
+{
+   mt19937 random(20240601);
+   uniform_int_distribution<int> small(-64, 64);
+   net.hidden = 64;
+   net.l1 = 32;
+   net.divisor = 16;
+   net.featureWeights.resize((size_t)NNUE_INPUTS * net.hidden);
+   net.featureBiases.resize(net.hidden);
+   net.l1Weights.resize((size_t)net.l1 * 2 * net.hidden);
+   net.l1Biases.resize(net.l1);
+   net.outputWeights.resize(net.l1);
+   for (int16_t& w : net.featureWeights)
+      w = (int16_t)small(random);
+   for (int16_t& b : net.featureBiases)
+      b = (int16_t)small(random);
+   for (int8_t& w : net.l1Weights)
+      w = (int8_t)small(random);
+   for (int32_t& b : net.l1Biases)
+      b = small(random);
+   for (int8_t& w : net.outputWeights)
+      w = (int8_t)small(random);
+   net.outputBias = 0;
+}
+
+/***************************************************
+ * CHECK
+ * Count a failure and describe the first few
+ ***************************************************/
+static void check(bool ok, const char* what, const Board& board, const string& when, int& failures)
+{
+   if (ok)
+      return;
+   if (failures < MAX_REPORTS)
+      cout << "FAILED " << what << " " << when << " in " << board.toFEN() << endl;
+   failures++;
+}
+
+/***************************************************
+ * CHECK BOARD
+ * The incremental state against a recompute. The
+ * fresh board is a copy, which rebuilds everything
+ * from the pieces
+ ***************************************************/
+static void checkBoard(const Board& board, Board& fresh, const string& when, int& failures)
+{
+   check(board.getKey() == board.computeKey(), "key", board, when, failures);
+
+   fresh = board;
+   check(board.getKey() == fresh.getKey(), "key of the pieces", board, when, failures);
+   check(board.getPsqMg() == fresh.getPsqMg() && board.getPsqEg() == fresh.getPsqEg(),
+         "piece-square sums", board, when, failures);
+   check(board.getPhase() == fresh.getPhase(), "phase", board, when, failures);
+   for (int perspective = 0; perspective < 2; perspective++)
+      check(memcmp(board.getAccumulator().values[perspective], fresh.getAccumulator().values[perspective],
+                   nnueNetwork->hidden * sizeof(int16_t)) == 0,
+            "accumulator", board, when, failures);
+}
+
+/***************************************************
+ * WALK
+ ***************************************************/
+static void walk(Board& board, Board& fresh, int depth, int& failures, uint64_t& moves)
+{
+   MoveList legal;
+   generateLegalMoves(board, legal);
+   for (PackedMove move : legal)
+   {
+      board.makeMove(move);
+      checkBoard(board, fresh, "after " + move.getCoordinates(), failures);
+      if (depth > 1)
+         walk(board, fresh, depth - 1, failures, moves);
+      board.unmakeMove();
+      checkBoard(board, fresh, "taking back " + move.getCoordinates(), failures);
+      moves++;
+   }
+}
+
+int main()
+{
+   Network net;
+   randomNetwork(net);
+   setNetwork(&net);
+
+   int failures = 0;
+   uint64_t moves = 0;
+   Board fresh;
+   for (int i = 0; i < perftPositionCount; i++)
+   {
+      Board board;
+      board.loadFEN(perftPositions[i].fen);
+      checkBoard(board, fresh, "loading", failures);
+      walk(board, fresh, DEPTH, failures, moves);
+   }
+   setNetwork(nullptr);
+
+   cout << moves << " moves, " << failures << " failures" << endl;
+   return failures ? 1 : 0;
+}
@@ -50,7 +50,7 @@ void Move::complete(const Board& board)
     if (board[source].getPieceType() == PAWN)
     {
         // For white pawns reaching the 8th rank or black pawns reaching the 1st rank
-        if ((isWhiteTurn && dest.getRow() == 0) || (!isWhiteTurn && dest.getRow() == 7))
+        if ((isWhiteTurn && dest.getRow() == 7) || (!isWhiteTurn && dest.getRow() == 0))
         {
             // Set promotion to QUEEN by default
             promote = QUEEN;
@@ -59,12 +59,9 @@ void Move::complete(const Board& board)
 
     // handle if this is an en-passant
     if (board[source].getPieceType() == PAWN) {
-        // Check if the move meets the conditions for en passant
-        if (!board.getMoveHistory().empty() && capture == SPACE &&
-            abs(board.getLastMove().getDes().getCol() - source.getCol()) == 1 &&
-            abs(board.getLastMove().getDes().getRow() == source.getRow()) &&
-            abs(board.getLastMove().getSrc().getRow() - source.getRow()) == 2 &&
-            dest.getCol() == board.getLastMove().getDes().getCol())
+        // Check if the pawn moves onto the square the opponent's pawn just skipped
+        if (capture == SPACE && dest.getLocation() == board.getEnPassant() &&
+            source.getCol() != dest.getCol())
         {
             // Set move as an enpassant
             enpassant = true;
@@ -134,6 +131,21 @@ bool Move::operator == (const Move & rhs) const
       return false;
 }
 
+/***********************************************
+ * MOVE : LESS THAN
+ * Order by source, then destination, then promotion
+ * so two pieces reaching the same square, or the
+ * four promotions of one pawn, stay distinct
+ **********************************************/
+bool Move::operator < (const Move & rhs) const
+{
+   if (source.getLocation() != rhs.source.getLocation())
+      return source.getLocation() < rhs.source.getLocation();
+   if (dest.getLocation() != rhs.dest.getLocation())
+      return dest.getLocation() < rhs.dest.getLocation();
+   return promote < rhs.promote;
+}
+
 /***********************************************
  * MOVE : LETTER FROM PIECE TYPE
  *        Get the Smith notation letter for a piece from
@@ -212,7 +224,7 @@ string Move::getText() const
    if (castleQ)
       sout << "C";
    if (promote != SPACE)
-      sout << toupper(letterFromPieceType(promote));
+      sout << (char)toupper(letterFromPieceType(promote));
    if (capture != SPACE && !enpassant)
       sout << letterFromPieceType(capture);
 
@@ -45,7 +45,7 @@ class Move
       bool operator == (const string & rhs) const { return getText() == rhs; }
       bool operator != (const string & rhs) const { return getText() != rhs; }
       bool operator != (const Move & rhs)   const { return !(*this == rhs); }
-      bool operator <  (const Move & rhs)   const { return dest.getLocation() < rhs.dest.getLocation(); }
+      bool operator <  (const Move & rhs)   const;
 
       // setters
       void setCapture(PieceType pt)     { capture    = pt;  }
@@ -0,0 +1,61 @@
+/***********************************************************************
+ * Header File:
+ *    MOVE LIST : A fixed-capacity list of moves
+ * Summary:
+ *    The moves generated from one position. The storage lives inside
+ *    the list itself, so filling one on the stack never allocates, and
+ *    each entry is a two byte PackedMove.
+ *    No legal chess position has more than 218 moves.
+ ************************************************************************/
+
+#pragma once
+
+#include "packedMove.h"
+
+const int MAX_MOVES = 256;
+
+/***************************************************
+ * GEN TYPE
+ * Which moves a generator should produce. Captures
+ * include every promotion; quiets are the rest, so
+ * the two together make all the moves
+ ***************************************************/
+enum GenType
+{
+   GEN_ALL,
+   GEN_CAPTURES,
+   GEN_QUIETS
+};
+
+/***************************************************
+ * MOVE LIST
+ * Contiguous moves in the order they were generated
+ ***************************************************/
+class MoveList
+{
+public:
+   MoveList() : count(0) {}
+
+   // getters
+   int  size()  const { return count;      }
+   bool empty() const { return count == 0; }
+   PackedMove operator [] (int i) const { return moves[i]; }
+   const PackedMove* begin() const { return moves;         }
+   const PackedMove* end()   const { return moves + count; }
+   bool contains(PackedMove move) const
+   {
+      for (int i = 0; i < count; i++)
+         if (moves[i] == move)
+            return true;
+      return false;
+   }
+
+   // setters
+   PackedMove& operator [] (int i) { return moves[i]; }
+   void add(PackedMove move) { moves[count++] = move; }
+   void clear()              { count = 0; }
+
+private:
+   PackedMove moves[MAX_MOVES];
+   int  count;
+};
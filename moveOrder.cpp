@@ -0,0 +1,143 @@
+/***********************************************************************
+ * Source File:
+ *    MOVE ORDER : Try the most promising moves first
+ * Summary:
+ *    Scores are spaced so each group in the header sorts above the
+ *    next whatever the scores within it
+ ************************************************************************/
+
+#include "moveOrder.h"
+#include "movegen.h"
+#include "eval.h"
+#include <cstring>
+#define NDEBUG
+#include <cassert>
+
+static const int SCORE_HASH    = 1 << 30;
+static const int SCORE_CAPTURE = 1 << 28;
+static const int SCORE_KILLER  = 1 << 27;
+static const int SCORE_COUNTER = 1 << 26;
+static const int SCORE_LOSING  = -(1 << 25);
+static const int SCORE_UNDER   = -(1 << 26);
+
+/***************************************************
+ * HEURISTICS : CLEAR
+ ***************************************************/
+void Heuristics::clear()
+{
+   for (int ply = 0; ply <= MAX_DEPTH; ply++)
+      killers[ply][0] = killers[ply][1] = PackedMove();
+   memset(history, 0, sizeof(history));
+   for (int from = 0; from < 64; from++)
+      for (int to = 0; to < 64; to++)
+         counters[from][to] = PackedMove();
+}
+
+/***************************************************
+ * HEURISTICS : UPDATE
+ * Reward the cutoff move and penalise the quiets
+ * searched before it. Each change is scaled by how
+ * far the entry is from the limit, so entries decay
+ * toward recent results instead of overflowing
+ *    INPUT board  the position, before best is made
+ ***************************************************/
+static void adjust(int& entry, int bonus)
+{
+   entry += bonus - entry * (bonus < 0 ? -bonus : bonus) / Heuristics::HISTORY_MAX;
+}
+
+void Heuristics::update(const Board& board, PackedMove best, const PackedMove* tried, int triedCount,
+                        int ply, int depth)
+{
+   bool isWhite = board.whiteTurn();
+   int bonus = depth * depth < 1200 ? depth * depth : 1200;
+
+   adjust(history[isWhite][best.getSrc()][best.getDes()], bonus);
+   for (int i = 0; i < triedCount; i++)
+      if (tried[i] != best)
+         adjust(history[isWhite][tried[i].getSrc()][tried[i].getDes()], -bonus);
+
+   if (killers[ply][0] != best)
+   {
+      killers[ply][1] = killers[ply][0];
+      killers[ply][0] = best;
+   }
+
+   PackedMove previous = board.getPreviousMove();
+   if (!previous.isNull())
+      counters[previous.getSrc()][previous.getDes()] = best;
+}
+
+/***************************************************
+ * MOVE PICKER : CONSTRUCTOR
+ ***************************************************/
+MovePicker::MovePicker(const Board& board, const Heuristics& heuristics, PackedMove hashMove, int ply,
+                       GenType gen) :
+   index(0)
+{
+   generateLegalMoves(board, moves, gen);
+   score(board, heuristics, hashMove, ply);
+}
+
+/***************************************************
+ * MOVE PICKER : SCORE
+ ***************************************************/
+void MovePicker::score(const Board& board, const Heuristics& heuristics, PackedMove hashMove, int ply)
+{
+   bool isWhite = board.whiteTurn();
+   PackedMove previous = board.getPreviousMove();
+   PackedMove counter = previous.isNull() ? PackedMove()
+                                          : heuristics.counters[previous.getSrc()][previous.getDes()];
+
+   for (int i = 0; i < moves.size(); i++)
+   {
+      PackedMove move = moves[i];
+      if (move == hashMove)
+         scores[i] = SCORE_HASH;
+      else if (move.isPromotion() && move.getPromotion() != QUEEN)
+         scores[i] = SCORE_UNDER + PIECE_VALUES[move.getPromotion()];
+      else if (move.isCapture() || move.isPromotion())
+      {
+         PieceType victim = move.isEnPassant() ? PAWN : board.pieceOn(move.getDes());
+         PieceType attacker = board.pieceOn(move.getSrc());
+         int mvvLva = PIECE_VALUES[victim] * 8 + PIECE_VALUES[move.getPromotion()]
+                    - PIECE_VALUES[attacker] / 8;
+         // only a bigger piece taking a smaller one can lose material
+         bool losing = PIECE_VALUES[attacker] > PIECE_VALUES[victim] && !move.isPromotion() &&
+                       board.see(move) < 0;
+         scores[i] = (losing ? SCORE_LOSING : SCORE_CAPTURE) + mvvLva;
+      }
+      else if (move == heuristics.killers[ply][0])
+         scores[i] = SCORE_KILLER + 1;
+      else if (move == heuristics.killers[ply][1])
+         scores[i] = SCORE_KILLER;
+      else if (move == counter)
+         scores[i] = SCORE_COUNTER;
+      else
+         scores[i] = heuristics.history[isWhite][move.getSrc()][move.getDes()];
+   }
+}
+
+/***************************************************
+ * MOVE PICKER : NEXT
+ * Selection sort, one step at a time
+ ***************************************************/
+bool MovePicker::next(PackedMove& move)
+{
+   if (index >= moves.size())
+      return false;
+
+   int best = index;
+   for (int i = index + 1; i < moves.size(); i++)
+      if (scores[i] > scores[best])
+         best = i;
+
+   move = moves[best];
+   moves[best] = moves[index];
+   moves[index] = move;
+   int score = scores[best];
+   scores[best] = scores[index];
+   scores[index] = score;
+   index++;
+   return true;
+}
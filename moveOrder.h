@@ -0,0 +1,71 @@
+/***********************************************************************
+ * Header File:
+ *    MOVE ORDER : Try the most promising moves first
+ * Summary:
+ *    Alpha-beta prunes the most when the best move is searched first.
+ *    Each move gets a score, and the picker hands them out best first:
+ *      1. the move the transposition table remembers
+ *      2. captures and queen promotions, most valuable victim first,
+ *         then least valuable attacker (MVV-LVA)
+ *      3. the two killers: quiet moves that caused a cutoff at this ply
+ *      4. the counter-move: the quiet move that last refuted the
+ *         opponent's previous move
+ *      5. other quiet moves by history: how often each from-to pair
+ *         has caused a cutoff for this side
+ *      6. captures that lose material in the exchange (Board::see)
+ *      7. under-promotions
+ *    The killers, history and counter-moves are learned as the search
+ *    goes, and each search thread keeps its own.
+ ************************************************************************/
+
+#pragma once
+
+#include "board.h"
+#include "moveList.h"
+#include "search.h"
+
+/***************************************************
+ * HEURISTICS
+ * What one search thread has learned about quiet moves
+ ***************************************************/
+struct Heuristics
+{
+   static const int HISTORY_MAX = 1 << 14;
+
+   PackedMove killers[MAX_DEPTH + 1][2];  // by ply
+   int        history[2][64][64];         // by [isWhite][from][to]
+   PackedMove counters[64][64];           // by the previous move's [from][to]
+
+   void clear();
+
+   // a quiet move caused a cutoff; the quiets tried before it did not
+   void update(const Board& board, PackedMove best, const PackedMove* tried, int triedCount,
+               int ply, int depth);
+};
+
+/***************************************************
+ * MOVE PICKER
+ * The legal moves of one position, handed out best
+ * first. Sorting only as far as the search gets keeps
+ * a cutoff on the first move cheap. The quiescence
+ * search asks for the captures alone
+ ***************************************************/
+class MovePicker
+{
+public:
+   MovePicker(const Board& board, const Heuristics& heuristics, PackedMove hashMove, int ply,
+              GenType gen = GEN_ALL);
+
+   // getters
+   int size() const { return moves.size(); }
+
+   // the next best move, false when there are no more
+   bool next(PackedMove& move);
+
+private:
+   void score(const Board& board, const Heuristics& heuristics, PackedMove hashMove, int ply);
+
+   MoveList moves;
+   int      scores[MAX_MOVES];
+   int      index;
+};
@@ -0,0 +1,111 @@
+/***********************************************************************
+ * Source File:
+ *    MOVE GENERATION : The legal moves of a position
+ * Summary:
+ *    A pseudo-legal move can only be illegal in a few ways:
+ *      - the king steps onto an attacked square, or castles out of,
+ *        through or into check
+ *      - a pinned piece leaves the line between its king and the pinner
+ *      - the side is in check and the move neither captures the
+ *        checker nor blocks it; in double check only the king may move
+ *      - an en-passant capture removes two pieces from one rank, which
+ *        can uncover a slider; that rare case is checked directly
+ ************************************************************************/
+
+#include "movegen.h"
+#include "attacks.h"
+#define NDEBUG
+#include <cassert>
+
+using namespace std;
+
+/***************************************************
+ * PINNED
+ * Our pieces that are the only thing between our king
+ * and an enemy slider looking at it
+ ***************************************************/
+static Bitboard pinned(const Board& board, int king, bool isWhite)
+{
+   Bitboard queens = board.getPieces(!isWhite, QUEEN);
+   Bitboard snipers = (rookAttacks(king, BB_EMPTY)   & (board.getPieces(!isWhite, ROOK)   | queens))
+                    | (bishopAttacks(king, BB_EMPTY) & (board.getPieces(!isWhite, BISHOP) | queens));
+   Bitboard result = BB_EMPTY;
+   while (snipers)
+   {
+      Bitboard blockers = betweenBB[king][popLsb(snipers)] & board.getOccupied();
+      if (blockers && !moreThanOne(blockers))
+         result |= blockers & board.getColour(isWhite);
+   }
+   return result;
+}
+
+/***************************************************
+ * GENERATE LEGAL MOVES
+ * Let each piece generate its moves, then keep the
+ * legal ones
+ *    INPUT  gen   all moves, or only captures or quiets
+ *           from  only the moves of the pieces on these squares
+ *    OUTPUT list  the legal moves are appended here
+ ***************************************************/
+void generateLegalMoves(const Board& board, MoveList& list, GenType gen, Bitboard from)
+{
+   bool isWhite = board.whiteTurn();
+   int king = lsb(board.getPieces(isWhite, KING));
+   Bitboard occupied = board.getOccupied();
+   Bitboard checks = board.attackersTo(king, !isWhite);
+   Bitboard pins = pinned(board, king, isWhite);
+
+   // squares a non-king move must land on: anywhere, or on the checker
+   // or between it and the king
+   Bitboard evasions = BB_ALL;
+   if (checks)
+      evasions = moreThanOne(checks) ? BB_EMPTY
+                                     : (checks | betweenBB[king][lsb(checks)]);
+
+   // in double check only the king moves, so skip everything else
+   Bitboard pieces = (moreThanOne(checks) ? squareBB(king) : board.getColour(isWhite)) & from;
+
+   MoveList moves;
+   while (pieces)
+   {
+      int sq = popLsb(pieces);
+      board[Position(sq)].getMoves(moves, board, gen);
+   }
+
+   for (PackedMove move : moves)
+   {
+      int src = move.getSrc();
+      int des = move.getDes();
+
+      if (src == king)
+      {
+         if (move.isCastle())
+         {
+            int step = move.getFlag() == MOVE_CASTLE_K ? 1 : -1;
+            if (checks ||
+                board.isSquareAttacked(src + step,     !isWhite) ||
+                board.isSquareAttacked(src + 2 * step, !isWhite))
+               continue;
+         }
+         // the king must not hide behind itself from a slider
+         else if (board.attackersTo(des, !isWhite, occupied ^ squareBB(king)))
+            continue;
+      }
+      else if (move.isEnPassant())
+      {
+         // make the capture on the occupancy alone and look again
+         int captured = (src / 8) * 8 + des % 8;
+         Bitboard after = (occupied ^ squareBB(src) ^ squareBB(captured)) | squareBB(des);
+         if (board.attackersTo(king, !isWhite, after) & ~squareBB(captured))
+            continue;
+      }
+      else
+      {
+         if (!(evasions & squareBB(des)))
+            continue;
+         if ((pins & squareBB(src)) && !aligned(king, src, des))
+            continue;
+      }
+      list.add(move);
+   }
+}
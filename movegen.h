@@ -0,0 +1,19 @@
+/***********************************************************************
+ * Header File:
+ *    MOVE GENERATION : The legal moves of a position
+ * Summary:
+ *    The pieces generate every move that follows their movement rules
+ *    (pseudo-legal moves). This weeds out the ones that leave the
+ *    mover's own king in check. The checking and pinned pieces are
+ *    found once per position; after that each move is accepted or
+ *    rejected by a few mask tests instead of being made and taken back.
+ ************************************************************************/
+
+#pragma once
+
+#include "board.h"
+#include "moveList.h"
+
+// the legal moves of the side to move, or just its captures or quiets,
+// or just those of some of its pieces
+void generateLegalMoves(const Board& board, MoveList& list, GenType gen = GEN_ALL, Bitboard from = BB_ALL);
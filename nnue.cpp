@@ -0,0 +1,188 @@
+/***********************************************************************
+ * Source File:
+ *    NNUE : An efficiently updatable neural network evaluation
+ * Summary:
+ *    Loading, the accumulator updates, and the forward pass. The
+ *    arithmetic is all in the kernels, picked for this CPU at load.
+ ************************************************************************/
+
+#include "nnue.h"
+#include "nnueKernels.h"
+#include "board.h"
+#include <cstdio>
+#include <memory>
+#define NDEBUG
+#include <cassert>
+
+using namespace std;
+
+const Network* nnueNetwork = nullptr;
+static unique_ptr<Network> loaded;
+static const NnueKernels* kernels = &scalarNnueKernels();
+
+/***************************************************
+ * READER
+ * Little-endian values from a file, whatever the
+ * byte order of this machine
+ ***************************************************/
+class Reader
+{
+public:
+   Reader(const string& fileName) : file(fopen(fileName.c_str(), "rb")), name(fileName)
+   {
+      if (file == nullptr)
+         throw string("Cannot open network file \"") + name + "\"";
+   }
+   ~Reader() { fclose(file); }
+
+   uint32_t u32()
+   {
+      unsigned char b[4];
+      bytes(b, 4);
+      return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+   }
+
+   void i16(vector<int16_t>& out, size_t count)
+   {
+      vector<unsigned char> b(count * 2);
+      bytes(b.data(), b.size());
+      out.resize(count);
+      for (size_t i = 0; i < count; i++)
+         out[i] = (int16_t)(b[2 * i] | (b[2 * i + 1] << 8));
+   }
+
+   void i8(vector<int8_t>& out, size_t count)
+   {
+      out.resize(count);
+      bytes((unsigned char*)out.data(), count);
+   }
+
+   void i32(vector<int32_t>& out, size_t count)
+   {
+      out.resize(count);
+      for (size_t i = 0; i < count; i++)
+         out[i] = (int32_t)u32();
+   }
+
+   void bytes(unsigned char* out, size_t count)
+   {
+      if (fread(out, 1, count, file) != count)
+         throw string("Network file \"") + name + "\" is too short";
+   }
+
+   bool atEnd() { return fgetc(file) == EOF; }
+
+private:
+   FILE* file;
+   string name;
+};
+
+/***************************************************
+ * LOAD NETWORK
+ ***************************************************/
+void loadNetwork(const string& fileName)
+{
+   Reader in(fileName);
+   unsigned char magic[4];
+   in.bytes(magic, 4);
+   if (magic[0] != 'N' || magic[1] != 'N' || magic[2] != 'U' || magic[3] != 'E' || in.u32() != 1)
+      throw string("\"") + fileName + "\" is not a version 1 network file";
+
+   unique_ptr<Network> network(new Network);
+   network->hidden  = (int)in.u32();
+   network->l1      = (int)in.u32();
+   network->divisor = (int)in.u32();
+   if (network->hidden <= 0 || network->hidden > NNUE_MAX_HIDDEN || network->hidden % 32 ||
+       network->l1 <= 0 || network->l1 > NNUE_MAX_L1 || network->l1 % 32 ||
+       network->divisor <= 0)
+      throw string("Network file \"") + fileName + "\" has unsupported layer sizes";
+
+   in.i16(network->featureWeights, (size_t)NNUE_INPUTS * network->hidden);
+   in.i16(network->featureBiases, network->hidden);
+   in.i8(network->l1Weights, (size_t)network->l1 * 2 * network->hidden);
+   in.i32(network->l1Biases, network->l1);
+   in.i8(network->outputWeights, network->l1);
+   network->outputBias = (int32_t)in.u32();
+   if (!in.atEnd())
+      throw string("Network file \"") + fileName + "\" is too long";
+
+   loaded = std::move(network);
+   setNetwork(loaded.get());
+}
+
+/***************************************************
+ * SET NETWORK
+ ***************************************************/
+void setNetwork(const Network* network)
+{
+   kernels = &bestNnueKernels();
+   nnueNetwork = network;
+}
+
+/***************************************************
+ * ACCUMULATOR UPDATES
+ * One weight row in or out for each point of view
+ ***************************************************/
+void nnueAdd(Accumulator& acc, PieceType pt, bool isWhite, int sq)
+{
+   int hidden = nnueNetwork->hidden;
+   const int16_t* weights = nnueNetwork->featureWeights.data();
+   for (int perspective = 0; perspective < 2; perspective++)
+      kernels->addRow(acc.values[perspective],
+                      weights + (size_t)nnueFeature(perspective != 0, pt, isWhite, sq) * hidden, hidden);
+}
+
+void nnueRemove(Accumulator& acc, PieceType pt, bool isWhite, int sq)
+{
+   int hidden = nnueNetwork->hidden;
+   const int16_t* weights = nnueNetwork->featureWeights.data();
+   for (int perspective = 0; perspective < 2; perspective++)
+      kernels->subRow(acc.values[perspective],
+                      weights + (size_t)nnueFeature(perspective != 0, pt, isWhite, sq) * hidden, hidden);
+}
+
+/***************************************************
+ * REFRESH
+ ***************************************************/
+void nnueRefresh(Accumulator& acc, const Board& board)
+{
+   for (int perspective = 0; perspective < 2; perspective++)
+      for (int i = 0; i < nnueNetwork->hidden; i++)
+         acc.values[perspective][i] = nnueNetwork->featureBiases[i];
+
+   for (int isWhite = 0; isWhite < 2; isWhite++)
+      for (int pt = KING; pt <= PAWN; pt++)
+      {
+         Bitboard pieces = board.getPieces(isWhite != 0, (PieceType)pt);
+         while (pieces)
+            nnueAdd(acc, (PieceType)pt, isWhite != 0, popLsb(pieces));
+      }
+}
+
+/***************************************************
+ * EVALUATE
+ * The side to move's half of the accumulator comes
+ * first, so the network always sees the position
+ * from the mover's side
+ ***************************************************/
+int nnueEvaluate(const Board& board)
+{
+   const Network& net = *nnueNetwork;
+   const Accumulator& acc = board.getAccumulator();
+   bool us = board.whiteTurn();
+
+   alignas(32) uint8_t input[2 * NNUE_MAX_HIDDEN];
+   kernels->clampRow(input,              acc.values[us],  net.hidden);
+   kernels->clampRow(input + net.hidden, acc.values[!us], net.hidden);
+
+   alignas(32) uint8_t hidden[NNUE_MAX_L1];
+   for (int i = 0; i < net.l1; i++)
+   {
+      int32_t sum = kernels->dot(input, net.l1Weights.data() + (size_t)i * 2 * net.hidden, 2 * net.hidden);
+      sum = (sum + net.l1Biases[i]) >> NNUE_L1_SHIFT;
+      hidden[i] = (uint8_t)(sum < 0 ? 0 : sum > 127 ? 127 : sum);
+   }
+
+   int32_t output = kernels->dot(hidden, net.outputWeights.data(), net.l1) + net.outputBias;
+   return output / net.divisor;
+}
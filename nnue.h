@@ -0,0 +1,97 @@
+/***********************************************************************
+ * Header File:
+ *    NNUE : An efficiently updatable neural network evaluation
+ * Summary:
+ *    An optional evaluation by a small network. Its first layer sees
+ *    768 inputs, one for each piece of each colour on each square, and
+ *    does so twice, once from each side's point of view. Only a few
+ *    inputs change per move, so the first layer's outputs (the
+ *    accumulator) are kept on the Board and updated by adding and
+ *    subtracting the weight rows of the pieces that moved. The
+ *    remaining layers are small and run from scratch on each call.
+ *
+ *    768 -> H, per side, in 16 bits
+ *    2H  -> L1, clamped to 0..127, with 8 bit weights
+ *    L1  -> 1
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pieceType.h"
+
+class Board;
+
+const int NNUE_INPUTS     = 768;
+const int NNUE_MAX_HIDDEN = 512;   // largest H a Board has room for
+const int NNUE_MAX_L1     = 256;
+const int NNUE_L1_SHIFT   = 6;     // second layer weights are scaled by 64
+
+/***************************************************
+ * ACCUMULATOR
+ * The first layer's outputs from each side's point
+ * of view, indexed by [isWhite]
+ ***************************************************/
+struct Accumulator
+{
+   alignas(32) int16_t values[2][NNUE_MAX_HIDDEN];
+};
+
+/***************************************************
+ * NETWORK
+ * The weights of a network as read from a file:
+ *    "NNUE"  magic
+ *    uint32  version, 1
+ *    uint32  H, a multiple of 32 up to NNUE_MAX_HIDDEN
+ *    uint32  L1, a multiple of 32 up to NNUE_MAX_L1
+ *    int32   divisor, output units per centipawn
+ *    int16   feature weights [768][H]
+ *    int16   feature biases  [H]
+ *    int8    L1 weights      [L1][2H]
+ *    int32   L1 biases       [L1]
+ *    int8    output weights  [L1]
+ *    int32   output bias
+ * everything little-endian
+ ***************************************************/
+struct Network
+{
+   int hidden;
+   int l1;
+   int divisor;
+   std::vector<int16_t> featureWeights;
+   std::vector<int16_t> featureBiases;
+   std::vector<int8_t>  l1Weights;
+   std::vector<int32_t> l1Biases;
+   std::vector<int8_t>  outputWeights;
+   int32_t              outputBias;
+};
+
+// load a network from a file and use it from now on; throws a string
+// describing the problem if the file cannot be used. Not while searching
+void loadNetwork(const std::string& fileName);
+
+// use one already in memory; nullptr goes back to the handcrafted evaluation
+void setNetwork(const Network* network);
+
+// the network in use, or nullptr
+extern const Network* nnueNetwork;
+
+// the first layer's input for one piece, from one side's point of view
+inline int nnueFeature(bool perspective, PieceType pt, bool isWhite, int sq)
+{
+   int relative = (perspective == isWhite) ? 0 : 1;
+   int square   = perspective ? sq : (sq ^ 56);
+   return (relative * 6 + (pt - KING)) * 64 + square;
+}
+
+// keep an accumulator in step with a piece arriving or leaving
+void nnueAdd(Accumulator& acc, PieceType pt, bool isWhite, int sq);
+void nnueRemove(Accumulator& acc, PieceType pt, bool isWhite, int sq);
+
+// build an accumulator from scratch from the board's pieces
+void nnueRefresh(Accumulator& acc, const Board& board);
+
+// centipawns for the side to move
+int nnueEvaluate(const Board& board);
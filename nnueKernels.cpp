@@ -0,0 +1,236 @@
+/***********************************************************************
+ * Source File:
+ *    NNUE KERNELS : The vector arithmetic of the network evaluation
+ * Summary:
+ *    The vector versions are compiled for their instruction set one
+ *    function at a time (a target attribute on GCC and Clang; MSVC
+ *    needs nothing), so the rest of the program does not require the
+ *    instructions and the build needs no special flags.
+ ************************************************************************/
+
+#include "nnueKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNUE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NNUE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NNUE_TARGET(isa)
+#endif
+
+/***************************************************
+ * SCALAR
+ ***************************************************/
+static void addRowScalar(int16_t* acc, const int16_t* row, int n)
+{
+   for (int i = 0; i < n; i++)
+      acc[i] = (int16_t)(acc[i] + row[i]);
+}
+
+static void subRowScalar(int16_t* acc, const int16_t* row, int n)
+{
+   for (int i = 0; i < n; i++)
+      acc[i] = (int16_t)(acc[i] - row[i]);
+}
+
+static void clampRowScalar(uint8_t* out, const int16_t* in, int n)
+{
+   for (int i = 0; i < n; i++)
+      out[i] = (uint8_t)(in[i] < 0 ? 0 : in[i] > 127 ? 127 : in[i]);
+}
+
+static int32_t dotScalar(const uint8_t* in, const int8_t* weights, int n)
+{
+   int32_t sum = 0;
+   for (int i = 0; i < n; i++)
+      sum += in[i] * weights[i];
+   return sum;
+}
+
+static const NnueKernels SCALAR = { "scalar", addRowScalar, subRowScalar, clampRowScalar, dotScalar };
+
+const NnueKernels& scalarNnueKernels()
+{
+   return SCALAR;
+}
+
+#ifdef NNUE_X86
+
+/***************************************************
+ * SSE
+ * SSE2 for the 16 bit rows, SSSE3 for the dot product
+ ***************************************************/
+NNUE_TARGET("sse2")
+static void addRowSse(int16_t* acc, const int16_t* row, int n)
+{
+   for (int i = 0; i < n; i += 8)
+   {
+      __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+      __m128i r = _mm_loadu_si128((const __m128i*)(row + i));
+      _mm_storeu_si128((__m128i*)(acc + i), _mm_add_epi16(a, r));
+   }
+}
+
+NNUE_TARGET("sse2")
+static void subRowSse(int16_t* acc, const int16_t* row, int n)
+{
+   for (int i = 0; i < n; i += 8)
+   {
+      __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+      __m128i r = _mm_loadu_si128((const __m128i*)(row + i));
+      _mm_storeu_si128((__m128i*)(acc + i), _mm_sub_epi16(a, r));
+   }
+}
+
+NNUE_TARGET("sse2")
+static void clampRowSse(uint8_t* out, const int16_t* in, int n)
+{
+   const __m128i max = _mm_set1_epi8(127);
+   for (int i = 0; i < n; i += 16)
+   {
+      __m128i lo = _mm_loadu_si128((const __m128i*)(in + i));
+      __m128i hi = _mm_loadu_si128((const __m128i*)(in + i + 8));
+      _mm_storeu_si128((__m128i*)(out + i), _mm_min_epu8(_mm_packus_epi16(lo, hi), max));
+   }
+}
+
+NNUE_TARGET("ssse3")
+static int32_t dotSsse3(const uint8_t* in, const int8_t* weights, int n)
+{
+   const __m128i ones = _mm_set1_epi16(1);
+   __m128i sum = _mm_setzero_si128();
+   for (int i = 0; i < n; i += 16)
+   {
+      __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+      __m128i w = _mm_loadu_si128((const __m128i*)(weights + i));
+      // pairs of u8 * i8 summed to i16 cannot saturate with inputs below 128
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(x, w), ones));
+   }
+   sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+   sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+   return _mm_cvtsi128_si32(sum);
+}
+
+static const NnueKernels SSE = { "ssse3", addRowSse, subRowSse, clampRowSse, dotSsse3 };
+
+/***************************************************
+ * AVX2
+ ***************************************************/
+NNUE_TARGET("avx2")
+static void addRowAvx2(int16_t* acc, const int16_t* row, int n)
+{
+   for (int i = 0; i < n; i += 16)
+   {
+      __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+      __m256i r = _mm256_loadu_si256((const __m256i*)(row + i));
+      _mm256_storeu_si256((__m256i*)(acc + i), _mm256_add_epi16(a, r));
+   }
+}
+
+NNUE_TARGET("avx2")
+static void subRowAvx2(int16_t* acc, const int16_t* row, int n)
+{
+   for (int i = 0; i < n; i += 16)
+   {
+      __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+      __m256i r = _mm256_loadu_si256((const __m256i*)(row + i));
+      _mm256_storeu_si256((__m256i*)(acc + i), _mm256_sub_epi16(a, r));
+   }
+}
+
+NNUE_TARGET("avx2")
+static void clampRowAvx2(uint8_t* out, const int16_t* in, int n)
+{
+   const __m256i max = _mm256_set1_epi8(127);
+   for (int i = 0; i < n; i += 32)
+   {
+      __m256i lo = _mm256_loadu_si256((const __m256i*)(in + i));
+      __m256i hi = _mm256_loadu_si256((const __m256i*)(in + i + 16));
+      // packing works within each 128 bit half, so put the quarters back in order
+      __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+      _mm256_storeu_si256((__m256i*)(out + i), _mm256_min_epu8(packed, max));
+   }
+}
+
+NNUE_TARGET("avx2")
+static int32_t dotAvx2(const uint8_t* in, const int8_t* weights, int n)
+{
+   const __m256i ones = _mm256_set1_epi16(1);
+   __m256i sum = _mm256_setzero_si256();
+   for (int i = 0; i < n; i += 32)
+   {
+      __m256i x = _mm256_loadu_si256((const __m256i*)(in + i));
+      __m256i w = _mm256_loadu_si256((const __m256i*)(weights + i));
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+   }
+   __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+   half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+   half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+   return _mm_cvtsi128_si32(half);
+}
+
+static const NnueKernels AVX2 = { "avx2", addRowAvx2, subRowAvx2, clampRowAvx2, dotAvx2 };
+
+/***************************************************
+ * CPU SUPPORT
+ ***************************************************/
+static bool hasAvx2()
+{
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 1);
+   bool osxsave = (info[2] & (1 << 27)) != 0;
+   bool avx     = (info[2] & (1 << 28)) != 0;
+   if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+      return false;
+   __cpuidex(info, 7, 0);
+   return (info[1] & (1 << 5)) != 0;
+#else
+   return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool hasSsse3()
+{
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 1);
+   return (info[2] & (1 << 9)) != 0;
+#else
+   return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+#endif // NNUE_X86
+
+/***************************************************
+ * SUPPORTED NNUE KERNELS
+ ***************************************************/
+std::vector<const NnueKernels*> supportedNnueKernels()
+{
+   std::vector<const NnueKernels*> sets;
+#ifdef NNUE_X86
+   if (hasAvx2())
+      sets.push_back(&AVX2);
+   if (hasSsse3())
+      sets.push_back(&SSE);
+#endif
+   sets.push_back(&SCALAR);
+   return sets;
+}
+
+/***************************************************
+ * BEST NNUE KERNELS
+ * Chosen once, the first time anyone asks
+ ***************************************************/
+const NnueKernels& bestNnueKernels()
+{
+   static const NnueKernels& best = *supportedNnueKernels().front();
+   return best;
+}
@@ -0,0 +1,42 @@
+/***********************************************************************
+ * Header File:
+ *    NNUE KERNELS : The vector arithmetic of the network evaluation
+ * Summary:
+ *    The few loops the network spends its time in, each written once
+ *    plainly and once for each x86 vector extension worth having. The
+ *    best set the CPU running the program supports is chosen when
+ *    first asked for, so one binary runs everywhere and still uses
+ *    AVX2 where it can. Lengths must be multiples of 32.
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/***************************************************
+ * NNUE KERNELS
+ ***************************************************/
+struct NnueKernels
+{
+   const char* name;
+
+   // acc[i] += row[i] and acc[i] -= row[i]
+   void (*addRow)(int16_t* acc, const int16_t* row, int n);
+   void (*subRow)(int16_t* acc, const int16_t* row, int n);
+
+   // out[i] = in[i] clamped to 0..127
+   void (*clampRow)(uint8_t* out, const int16_t* in, int n);
+
+   // the sum of in[i] * weights[i]; in must be 0..127
+   int32_t (*dot)(const uint8_t* in, const int8_t* weights, int n);
+};
+
+// the fastest kernels this CPU can run
+const NnueKernels& bestNnueKernels();
+
+// plain C++, for any CPU and for checking the others against
+const NnueKernels& scalarNnueKernels();
+
+// every set this CPU can run, fastest first, ending with the scalar one
+std::vector<const NnueKernels*> supportedNnueKernels();
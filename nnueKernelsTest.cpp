@@ -0,0 +1,103 @@
+/**********************************************************************
+ * NNUE KERNELS TEST
+ * Every set of kernels this CPU can run must give exactly what the
+ * plain C++ ones give, for every length the network can have and for
+ * inputs reaching the ends of their ranges. Exits non-zero on the
+ * first difference
+ **********************************************************************/
+
+#include "nnueKernels.h"
+#include "nnue.h"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/***************************************************
+ * CHECK KERNELS
+ * One set against the scalar set on random rows of
+ * length n. Returns false and says why on a mismatch
+ ***************************************************/
+static bool checkKernels(const NnueKernels& kernels, int n, mt19937& random)
+{
+   const NnueKernels& scalar = scalarNnueKernels();
+   uniform_int_distribution<int> anyInt16(INT16_MIN, INT16_MAX);
+   uniform_int_distribution<int> anyInt8(INT8_MIN, INT8_MAX);
+   uniform_int_distribution<int> anyInput(0, 127);
+
+   vector<int16_t> acc(n), row(n), expected(n), actual(n);
+   vector<int8_t> weights(n);
+   vector<uint8_t> in(n), clampExpected(n), clampActual(n);
+   for (int i = 0; i < n; i++)
+   {
+      acc[i] = (int16_t)anyInt16(random);
+      row[i] = (int16_t)anyInt16(random);
+      weights[i] = (int8_t)anyInt8(random);
+      in[i] = (uint8_t)anyInput(random);
+   }
+
+   expected = acc;
+   actual = acc;
+   scalar.addRow(expected.data(), row.data(), n);
+   kernels.addRow(actual.data(), row.data(), n);
+   if (expected != actual)
+   {
+      cout << kernels.name << " addRow differs for n = " << n << endl;
+      return false;
+   }
+
+   expected = acc;
+   actual = acc;
+   scalar.subRow(expected.data(), row.data(), n);
+   kernels.subRow(actual.data(), row.data(), n);
+   if (expected != actual)
+   {
+      cout << kernels.name << " subRow differs for n = " << n << endl;
+      return false;
+   }
+
+   scalar.clampRow(clampExpected.data(), acc.data(), n);
+   kernels.clampRow(clampActual.data(), acc.data(), n);
+   if (clampExpected != clampActual)
+   {
+      cout << kernels.name << " clampRow differs for n = " << n << endl;
+      return false;
+   }
+
+   // random inputs, then the largest products of each sign
+   for (int extreme = 0; extreme < 3; extreme++)
+   {
+      if (extreme)
+         for (int i = 0; i < n; i++)
+         {
+            in[i] = 127;
+            weights[i] = extreme == 1 ? INT8_MAX : INT8_MIN;
+         }
+      int32_t sumExpected = scalar.dot(in.data(), weights.data(), n);
+      int32_t sumActual = kernels.dot(in.data(), weights.data(), n);
+      if (sumExpected != sumActual)
+      {
+         cout << kernels.name << " dot gives " << sumActual << " instead of "
+              << sumExpected << " for n = " << n << endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+int main()
+{
+   mt19937 random(20240601);
+   int maxLength = 2 * NNUE_MAX_HIDDEN;
+   for (const NnueKernels* kernels : supportedNnueKernels())
+   {
+      for (int round = 0; round < 100; round++)
+         for (int n = 32; n <= maxLength; n += 32)
+            if (!checkKernels(*kernels, n, random))
+               return 1;
+      cout << kernels->name << ": ok" << endl;
+   }
+   return 0;
+}
@@ -0,0 +1,418 @@
+/***********************************************************************
+ * Source File:
+ *    NOTATION : Moves as text
+ * Summary:
+ *    Writing goes a character at a time into the caller's buffer. Reading
+ *    takes the text apart into what it says about the move, and then the
+ *    legal moves of the piece named are searched for the one that fits.
+ *    Check and annotation marks are ignored when reading, as is whether
+ *    a capture is marked.
+ ************************************************************************/
+
+#include "notation.h"
+#include "movegen.h"
+#define NDEBUG
+#include <cassert>
+
+using namespace std;
+
+/***************************************************
+ * TEXT WRITER
+ * Appends to a caller's buffer, always leaving room
+ * for the '\0', and remembers if anything did not fit
+ ***************************************************/
+class TextWriter
+{
+public:
+   TextWriter(char* text, size_t size) : text(text), size(size), length(0), full(size == 0) {}
+
+   void put(char c)
+   {
+      if (length + 1 < size)
+         text[length++] = c;
+      else
+         full = true;
+   }
+   void put(const char* s)
+   {
+      while (*s)
+         put(*s++);
+   }
+   void putSquare(int sq)
+   {
+      put((char)('a' + sq % 8));
+      put((char)('1' + sq / 8));
+   }
+
+   // terminate the text: NOTATION_NO_ROOM if it was cut short
+   NotationError finish()
+   {
+      if (size > 0)
+         text[length] = '\0';
+      return full ? NOTATION_NO_ROOM : NOTATION_OK;
+   }
+
+private:
+   char*  text;
+   size_t size;
+   size_t length;
+   bool   full;
+};
+
+/***************************************************
+ * PIECE OF LETTER
+ * The piece a SAN letter names, SPACE for none
+ ***************************************************/
+static PieceType pieceOfLetter(char letter)
+{
+   switch (letter)
+   {
+      case 'K':
+         return KING;
+      case 'Q':
+         return QUEEN;
+      case 'R':
+         return ROOK;
+      case 'B':
+         return BISHOP;
+      case 'N':
+         return KNIGHT;
+      default:
+         return SPACE;
+   }
+}
+
+/***************************************************
+ * LETTER OF PIECE
+ * The upper case letter of a piece, ' ' for none
+ ***************************************************/
+static char letterOfPiece(PieceType pt)
+{
+   static const char LETTERS[] = " KQRBNP";
+   return LETTERS[pt];
+}
+
+/***************************************************
+ * READ SQUARE
+ * Two characters such as "e4", -1 if they are not
+ ***************************************************/
+static int readSquare(string_view text)
+{
+   if (text.size() < 2 || text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8')
+      return -1;
+   return (text[1] - '1') * 8 + (text[0] - 'a');
+}
+
+/***************************************************
+ * FIND MOVE
+ * The one legal move of a piece to a square
+ *    INPUT  board      the position
+ *           src        where the piece is
+ *           des        where it goes
+ *           promotion  what it becomes, SPACE if nothing
+ *    OUTPUT move       the legal move
+ ***************************************************/
+static NotationError findMove(const Board& board, int src, int des, PieceType promotion, PackedMove& move)
+{
+   MoveList legal;
+   generateLegalMoves(board, legal, GEN_ALL, squareBB(src));
+   for (PackedMove m : legal)
+      if (m.getDes() == des && m.getPromotion() == promotion)
+      {
+         move = m;
+         return NOTATION_OK;
+      }
+   return NOTATION_ILLEGAL;
+}
+
+/***************************************************
+ * NOTATION ERROR TEXT
+ ***************************************************/
+const char* notationErrorText(NotationError error)
+{
+   switch (error)
+   {
+      case NOTATION_OK:
+         return "ok";
+      case NOTATION_SYNTAX:
+         return "unreadable move";
+      case NOTATION_ILLEGAL:
+         return "illegal move";
+      case NOTATION_AMBIGUOUS:
+         return "ambiguous move";
+      case NOTATION_NO_ROOM:
+         return "move text too long";
+   }
+   assert(false);
+   return "unknown error";
+}
+
+/***************************************************
+ * WRITE SMITH
+ * The squares, then E for en-passant, c or C for
+ * castling, the promotion in upper case and the
+ * piece captured in lower case: "b7a8Qr"
+ ***************************************************/
+NotationError writeSmith(const Board& board, PackedMove move, char* text, size_t size)
+{
+   assert(!move.isNull());
+   TextWriter out(text, size);
+   out.putSquare(move.getSrc());
+   out.putSquare(move.getDes());
+
+   if (move.isEnPassant())
+      out.put('E');
+   else if (move.getFlag() == MOVE_CASTLE_K)
+      out.put('c');
+   else if (move.getFlag() == MOVE_CASTLE_Q)
+      out.put('C');
+   if (move.isPromotion())
+      out.put(letterOfPiece(move.getPromotion()));
+   if (move.isCapture() && !move.isEnPassant())
+      out.put((char)(letterOfPiece(board.pieceOn(move.getDes())) - 'A' + 'a'));
+   return out.finish();
+}
+
+/***************************************************
+ * WRITE UCI
+ * The squares and a lower case promotion: "e7e8q".
+ * The null move is "0000"
+ ***************************************************/
+NotationError writeUCI(PackedMove move, char* text, size_t size)
+{
+   static const char PROMOTIONS[] = "nbrq";
+   TextWriter out(text, size);
+   if (move.isNull())
+   {
+      out.put("0000");
+      return out.finish();
+   }
+
+   out.putSquare(move.getSrc());
+   out.putSquare(move.getDes());
+   if (move.isPromotion())
+      out.put(PROMOTIONS[move.getFlag() & 3]);
+   return out.finish();
+}
+
+/***************************************************
+ * WRITE SAN
+ * The piece letter, where it came from when another
+ * piece of the same kind can reach the square (the
+ * file if that tells them apart, else the rank, else
+ * both), x for a capture, the square, the promotion,
+ * and + or # when it gives check or mate
+ *    INPUT  board  the position, left as it was found
+ *           move   a legal move
+ *    OUTPUT text   such as "Nbd7", "exd6", "e8=Q+"
+ ***************************************************/
+NotationError writeSAN(Board& board, PackedMove move, char* text, size_t size)
+{
+   assert(!move.isNull());
+   TextWriter out(text, size);
+   int src = move.getSrc();
+   int des = move.getDes();
+
+   if (move.getFlag() == MOVE_CASTLE_K)
+      out.put("O-O");
+   else if (move.getFlag() == MOVE_CASTLE_Q)
+      out.put("O-O-O");
+   else
+   {
+      PieceType pt = board.pieceOn(src);
+      if (pt == PAWN)
+      {
+         if (move.isCapture())
+            out.put((char)('a' + src % 8));
+      }
+      else
+      {
+         out.put(letterOfPiece(pt));
+
+         // the other pieces of this kind that can go there
+         bool ambiguous = false;
+         bool sameFile = false;
+         bool sameRank = false;
+         if (pt != KING)
+         {
+            MoveList legal;
+            generateLegalMoves(board, legal, GEN_ALL, board.getPieces(board.whiteTurn(), pt) & ~squareBB(src));
+            for (PackedMove m : legal)
+               if (m.getDes() == des)
+               {
+                  ambiguous = true;
+                  sameFile |= m.getSrc() % 8 == src % 8;
+                  sameRank |= m.getSrc() / 8 == src / 8;
+               }
+         }
+         if (ambiguous && (!sameFile || sameRank))
+            out.put((char)('a' + src % 8));
+         if (ambiguous && sameFile)
+            out.put((char)('1' + src / 8));
+      }
+
+      if (move.isCapture())
+         out.put('x');
+      out.putSquare(des);
+      if (move.isPromotion())
+      {
+         out.put('=');
+         out.put(letterOfPiece(move.getPromotion()));
+      }
+   }
+
+   // check, and mate when there is no way out of it
+   board.makeMove(move);
+   if (board.inCheck())
+   {
+      MoveList replies;
+      generateLegalMoves(board, replies);
+      out.put(replies.empty() ? '#' : '+');
+   }
+   board.unmakeMove();
+
+   return out.finish();
+}
+
+/***************************************************
+ * READ SMITH
+ *    INPUT  board  the position the move is played from
+ *           text   such as "e2e4", "e1g1c" or "b7a8Qr"
+ *    OUTPUT move   the legal move it names
+ ***************************************************/
+NotationError readSmith(const Board& board, string_view text, PackedMove& move)
+{
+   int src = readSquare(text);
+   int des = text.size() >= 4 ? readSquare(text.substr(2)) : -1;
+   if (src < 0 || des < 0)
+      return NOTATION_SYNTAX;
+
+   // the capture, castle and en-passant marks follow from the squares
+   PieceType promotion = SPACE;
+   for (char c : text.substr(4))
+   {
+      if (pieceOfLetter(c) != SPACE && c != 'K')
+         promotion = pieceOfLetter(c);
+      else if (c != 'p' && c != 'n' && c != 'b' && c != 'r' && c != 'q' && c != 'k' &&
+               c != 'c' && c != 'C' && c != 'E')
+         return NOTATION_SYNTAX;
+   }
+
+   return findMove(board, src, des, promotion, move);
+}
+
+/***************************************************
+ * READ UCI
+ *    INPUT  board  the position the move is played from
+ *           text   such as "e2e4" or "e7e8q"
+ *    OUTPUT move   the legal move it names
+ ***************************************************/
+NotationError readUCI(const Board& board, string_view text, PackedMove& move)
+{
+   if (text.size() != 4 && text.size() != 5)
+      return NOTATION_SYNTAX;
+   int src = readSquare(text);
+   int des = readSquare(text.substr(2));
+   if (src < 0 || des < 0)
+      return NOTATION_SYNTAX;
+
+   PieceType promotion = SPACE;
+   if (text.size() == 5)
+   {
+      promotion = pieceOfLetter((char)(text[4] - 'a' + 'A'));
+      if (promotion == SPACE || promotion == KING)
+         return NOTATION_SYNTAX;
+   }
+
+   return findMove(board, src, des, promotion, move);
+}
+
+/***************************************************
+ * READ SAN
+ *    INPUT  board  the position the move is played from
+ *           text   such as "Nbd7", "exd6", "e8=Q+" or "O-O"
+ *    OUTPUT move   the legal move it names
+ ***************************************************/
+NotationError readSAN(const Board& board, string_view text, PackedMove& move)
+{
+   // check, mate and annotations say nothing about the move itself
+   while (!text.empty() && (text.back() == '+' || text.back() == '#' ||
+                            text.back() == '!' || text.back() == '?'))
+      text.remove_suffix(1);
+
+   // only the moves of the piece named need to be generated
+   MoveList legal;
+   bool isWhite = board.whiteTurn();
+
+   // castling, with letter O or digit zero
+   if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0")
+   {
+      generateLegalMoves(board, legal, GEN_ALL, board.getPieces(isWhite, KING));
+      int flag = text.size() == 3 ? MOVE_CASTLE_K : MOVE_CASTLE_Q;
+      for (PackedMove m : legal)
+         if (m.getFlag() == flag)
+         {
+            move = m;
+            return NOTATION_OK;
+         }
+      return NOTATION_ILLEGAL;
+   }
+
+   // the piece, a pawn when there is no letter
+   PieceType pt = PAWN;
+   if (!text.empty() && pieceOfLetter(text.front()) != SPACE)
+   {
+      pt = pieceOfLetter(text.front());
+      text.remove_prefix(1);
+   }
+
+   // a promotion at the end, usually but not always after '='
+   PieceType promotion = SPACE;
+   if (pt == PAWN && !text.empty() && pieceOfLetter(text.back()) != SPACE)
+   {
+      promotion = pieceOfLetter(text.back());
+      text.remove_suffix(1);
+      if (!text.empty() && text.back() == '=')
+         text.remove_suffix(1);
+   }
+
+   // the destination is the last square named
+   if (text.size() < 2)
+      return NOTATION_SYNTAX;
+   int des = readSquare(text.substr(text.size() - 2));
+   if (des < 0)
+      return NOTATION_SYNTAX;
+   text.remove_suffix(2);
+
+   // whatever is left says where it came from
+   int fromFile = -1;
+   int fromRank = -1;
+   for (char c : text)
+   {
+      if (c >= 'a' && c <= 'h')
+         fromFile = c - 'a';
+      else if (c >= '1' && c <= '8')
+         fromRank = c - '1';
+      else if (c != 'x' && c != ':' && c != '-')
+         return NOTATION_SYNTAX;
+   }
+
+   Bitboard from = board.getPieces(isWhite, pt);
+   if (fromFile >= 0)
+      from &= colBB(fromFile);
+   if (fromRank >= 0)
+      from &= rowBB(fromRank);
+   generateLegalMoves(board, legal, GEN_ALL, from);
+
+   int found = 0;
+   for (PackedMove m : legal)
+   {
+      if (m.getDes() != des || m.getPromotion() != promotion)
+         continue;
+      move = m;
+      found++;
+   }
+   if (found == 0)
+      return NOTATION_ILLEGAL;
+   return found == 1 ? NOTATION_OK : NOTATION_AMBIGUOUS;
+}
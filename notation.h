@@ -0,0 +1,52 @@
+/***********************************************************************
+ * Header File:
+ *    NOTATION : Moves as text
+ * Summary:
+ *    Three ways of writing a move down:
+ *       Smith  the board's own files: "e5d6E", "e1g1c", "b7a8Qr"
+ *       UCI    what other engines read and print: "e2e4", "e7e8q"
+ *       SAN    what game records use: the piece and the square it lands
+ *              on, with just enough of where it came from to tell it
+ *              apart from another piece that could go there, such as
+ *              "Nbd7", "exd6", "e8=Q+" or "O-O"
+ *    Moves are written into the caller's buffer and read from a view of
+ *    the caller's text, so exporting or importing a game allocates
+ *    nothing. Failures come back as a NotationError rather than thrown.
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include "board.h"
+#include "packedMove.h"
+
+// room for the longest move in any of the notations, with its '\0'
+const size_t NOTATION_SIZE = 8;
+
+/***************************************************
+ * NOTATION ERROR
+ * Why a move could not be read or written
+ ***************************************************/
+enum NotationError
+{
+   NOTATION_OK = 0,
+   NOTATION_SYNTAX,       // the text is not a move in that notation
+   NOTATION_ILLEGAL,      // names no legal move in the position
+   NOTATION_AMBIGUOUS,    // names more than one legal move
+   NOTATION_NO_ROOM       // the buffer is too small for the text
+};
+
+// a few words describing the error, for messages
+const char* notationErrorText(NotationError error);
+
+// write a move, which must be legal on the board, as '\0' terminated text.
+// SAN makes the move and takes it back to see whether it checks or mates
+NotationError writeSmith(const Board& board, PackedMove move, char* text, size_t size);
+NotationError writeUCI(PackedMove move, char* text, size_t size);
+NotationError writeSAN(Board& board, PackedMove move, char* text, size_t size);
+
+// the legal move the text names
+NotationError readSmith(const Board& board, std::string_view text, PackedMove& move);
+NotationError readUCI(const Board& board, std::string_view text, PackedMove& move);
+NotationError readSAN(const Board& board, std::string_view text, PackedMove& move);
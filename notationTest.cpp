@@ -0,0 +1,94 @@
+/**********************************************************************
+ * NOTATION TEST
+ * Every position within a few moves of the perft reference positions
+ * must survive being written as FEN and read back, and every legal
+ * move in them must survive being written and read back as UCI, SAN
+ * and Smith text. Exits non-zero after reporting the first failures
+ **********************************************************************/
+
+#include "notation.h"
+#include "movegen.h"
+#include "perft.h"
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const int DEPTH = 3;
+static const int MAX_REPORTS = 10;
+
+/***************************************************
+ * CHECK
+ * Count a failure and describe the first few
+ ***************************************************/
+static void check(bool ok, int& failures, const Board& board, const string& what)
+{
+   if (ok)
+      return;
+   if (failures < MAX_REPORTS)
+      cout << "FAILED " << what << " in " << board.toFEN() << endl;
+   failures++;
+}
+
+/***************************************************
+ * WALK
+ * Check this position and its moves, then every
+ * position below it to the given depth
+ ***************************************************/
+static void walk(Board& board, Board& copy, int depth, int& failures, uint64_t& moves)
+{
+   string fen = board.toFEN();
+   try
+   {
+      copy.loadFEN(fen);
+      check(copy.toFEN() == fen && copy.getKey() == board.getKey(), failures, board, "FEN " + fen);
+   }
+   catch (const string& error)
+   {
+      check(false, failures, board, "FEN " + error);
+   }
+
+   MoveList legal;
+   generateLegalMoves(board, legal);
+   for (PackedMove move : legal)
+   {
+      char text[NOTATION_SIZE];
+      PackedMove read;
+
+      bool ok = writeUCI(move, text, sizeof(text)) == NOTATION_OK &&
+                readUCI(board, text, read) == NOTATION_OK && read == move;
+      check(ok, failures, board, string("UCI ") + text);
+
+      ok = writeSAN(board, move, text, sizeof(text)) == NOTATION_OK &&
+           readSAN(board, text, read) == NOTATION_OK && read == move;
+      check(ok, failures, board, string("SAN ") + text);
+
+      ok = writeSmith(board, move, text, sizeof(text)) == NOTATION_OK &&
+           readSmith(board, text, read) == NOTATION_OK && read == move;
+      check(ok, failures, board, string("Smith ") + text);
+
+      moves++;
+      if (depth > 1)
+      {
+         board.makeMove(move);
+         walk(board, copy, depth - 1, failures, moves);
+         board.unmakeMove();
+      }
+   }
+}
+
+int main()
+{
+   int failures = 0;
+   uint64_t moves = 0;
+   Board copy;
+   for (int i = 0; i < perftPositionCount; i++)
+   {
+      Board board;
+      board.loadFEN(perftPositions[i].fen);
+      walk(board, copy, DEPTH, failures, moves);
+   }
+
+   cout << moves << " moves, " << failures << " failures" << endl;
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/***********************************************************************
+ * Source File:
+ *    PACKED MOVE : A chess move in 16 bits
+ * Summary:
+ *    Conversion between the packed move and the full Move class,
+ *    including the Smith notation text
+ ************************************************************************/
+
+#include "packedMove.h"
+#include "move.h"
+#include "board.h"
+#include "notation.h"
+#define NDEBUG
+#include <cassert>
+
+using namespace std;
+
+/***************************************************
+ * PACKED MOVE : FROM MOVE
+ * Everything but the captured piece type and the
+ * colour fits in the flag
+ ***************************************************/
+PackedMove::PackedMove(const Move& move) : data(0)
+{
+   int flag = MOVE_QUIET;
+   if (move.getCastleK())
+      flag = MOVE_CASTLE_K;
+   else if (move.getCastleQ())
+      flag = MOVE_CASTLE_Q;
+   else if (move.getEnPassant())
+      flag = MOVE_EN_PASSANT;
+   else if (move.getPromotion() != SPACE)
+      flag = promoteFlag(move.getPromotion(), move.getCapture() != SPACE);
+   else if (move.getCapture() != SPACE)
+      flag = MOVE_CAPTURE;
+
+   *this = PackedMove(move.getSrc().getLocation(), move.getDes().getLocation(), flag);
+}
+
+/***************************************************
+ * PACKED MOVE : FROM SMITH TEXT
+ * Parsed by Move, so a bad string throws the same way
+ ***************************************************/
+PackedMove::PackedMove(const string& smith) : PackedMove(Move(smith.c_str()))
+{
+}
+
+/***************************************************
+ * PACKED MOVE : PROMOTE FLAG
+ ***************************************************/
+int PackedMove::promoteFlag(PieceType pt, bool capture)
+{
+   int base = capture ? MOVE_PROMOTE_CAPTURE : MOVE_PROMOTE;
+   switch (pt)
+   {
+      case KNIGHT:
+         return base + 0;
+      case BISHOP:
+         return base + 1;
+      case ROOK:
+         return base + 2;
+      case QUEEN:
+         return base + 3;
+      default:
+         assert(false);
+         return base + 3;
+   }
+}
+
+/***************************************************
+ * PACKED MOVE : GET PROMOTION
+ ***************************************************/
+PieceType PackedMove::getPromotion() const
+{
+   static const PieceType PROMOTIONS[4] = { KNIGHT, BISHOP, ROOK, QUEEN };
+   return isPromotion() ? PROMOTIONS[getFlag() & 3] : SPACE;
+}
+
+/***************************************************
+ * PACKED MOVE : TO MOVE
+ * Expand into a full Move. The board must be the
+ * position before the move is made so the colour
+ * and the captured piece can be read off it
+ ***************************************************/
+Move PackedMove::toMove(const Board& board) const
+{
+   Move move(Position(getSrc()), Position(getDes()), getPromotion());
+   move.setWhiteMove(board[move.getSrc()].getIsWhite());
+
+   if (isEnPassant())
+      move.setEnPassant();
+   else if (getFlag() == MOVE_CASTLE_K)
+      move.setCastle(true /*isKing*/);
+   else if (getFlag() == MOVE_CASTLE_Q)
+      move.setCastle(false /*isKing*/);
+   else if (isCapture())
+      move.setCapture(board[move.getDes()].getPieceType());
+
+   return move;
+}
+
+/***************************************************
+ * PACKED MOVE : GET TEXT
+ * Smith notation, which names the captured piece
+ ***************************************************/
+string PackedMove::getText(const Board& board) const
+{
+   char text[NOTATION_SIZE];
+   writeSmith(board, *this, text, sizeof(text));
+   return text;
+}
+
+/***************************************************
+ * PACKED MOVE : GET COORDINATES
+ * Coordinate notation, such as "e7e8q", the form other
+ * engines read and print. Needs no board
+ ***************************************************/
+string PackedMove::getCoordinates() const
+{
+   char text[NOTATION_SIZE];
+   writeUCI(*this, text, sizeof(text));
+   return text;
+}
@@ -0,0 +1,80 @@
+/***********************************************************************
+ * Header File:
+ *    PACKED MOVE : A chess move in 16 bits
+ * Summary:
+ *    The source square, the destination square and a four bit flag
+ *    packed into one 16 bit word. Trivially copyable, so it is what
+ *    move lists, the history, the hash table and game files store.
+ *    Convert to a full Move when the board is needed to fill in the
+ *    rest, such as the piece captured.
+ *
+ *    bits  0- 5  source location      (Position::getLocation())
+ *    bits  6-11  destination location
+ *    bits 12-15  flag                 (MoveFlag)
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "pieceType.h"
+
+class Move;
+class Board;
+
+/***************************************************
+ * MOVE FLAG
+ * Bit 2 marks a capture, bit 3 a promotion. The low
+ * two bits of a promotion give the new piece
+ ***************************************************/
+enum MoveFlag
+{
+   MOVE_QUIET       = 0,
+   MOVE_CASTLE_K    = 2,
+   MOVE_CASTLE_Q    = 3,
+   MOVE_CAPTURE     = 4,
+   MOVE_EN_PASSANT  = 5,
+   MOVE_PROMOTE     = 8,   // + 0 knight, 1 bishop, 2 rook, 3 queen
+   MOVE_PROMOTE_CAPTURE = 12
+};
+
+/***************************************************
+ * PACKED MOVE
+ * One move in two bytes
+ ***************************************************/
+class PackedMove
+{
+public:
+   PackedMove() : data(0) {}
+   PackedMove(int src, int des, int flag = MOVE_QUIET) :
+      data((uint16_t)(src | (des << 6) | (flag << 12))) {}
+   explicit PackedMove(const Move& move);
+   explicit PackedMove(const std::string& smith);
+
+   // getters
+   int  getSrc()       const { return data & 0x3f;         }
+   int  getDes()       const { return (data >> 6) & 0x3f;  }
+   int  getFlag()      const { return data >> 12;          }
+   uint16_t getRaw()   const { return data;                }
+   bool isNull()       const { return data == 0;           }
+   bool isCapture()    const { return (getFlag() & MOVE_CAPTURE) != 0; }
+   bool isPromotion()  const { return (getFlag() & MOVE_PROMOTE) != 0; }
+   bool isEnPassant()  const { return getFlag() == MOVE_EN_PASSANT;   }
+   bool isCastle()     const { return getFlag() == MOVE_CASTLE_K ||
+                                      getFlag() == MOVE_CASTLE_Q;     }
+   PieceType getPromotion() const;
+   Move toMove(const Board& board) const;
+   std::string getText(const Board& board) const;
+   std::string getCoordinates() const;
+   bool operator == (const PackedMove& rhs) const { return data == rhs.data; }
+   bool operator != (const PackedMove& rhs) const { return data != rhs.data; }
+
+   // the flag of a promotion to the given piece
+   static int promoteFlag(PieceType pt, bool capture);
+
+   // game files store the raw 16 bits
+   static PackedMove fromRaw(uint16_t raw) { PackedMove m; m.data = raw; return m; }
+
+private:
+   uint16_t data;
+};
@@ -0,0 +1,231 @@
+/***********************************************************************
+ * Source File:
+ *    PERFT : Count the positions reachable from a position
+ * Summary:
+ *    Moves come from the legal move generator and are played with
+ *    Board::makeMove, the same path the game uses. The parallel count
+ *    splits the top of the tree into subtree tasks on a work-stealing
+ *    thread pool; each worker replays a task's moves on its own board.
+ ************************************************************************/
+
+#include "perft.h"
+#include "movegen.h"
+#include "threadPool.h"
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <vector>
+#define NDEBUG
+#include <cassert>
+
+using namespace std;
+
+/***************************************************
+ * PERFT POSITIONS
+ * From the Chess Programming Wiki perft results page
+ ***************************************************/
+const PerftPosition perftPositions[] =
+{
+   { "start",
+     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+     { 20, 400, 8902, 197281, 4865609, 119060324 } },
+   { "kiwipete",
+     "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     { 48, 2039, 97862, 4085603, 193690690, 0 } },
+   { "position 3",
+     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     { 14, 191, 2812, 43238, 674624, 11030083 } },
+   { "position 4",
+     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     { 6, 264, 9467, 422333, 15833292, 0 } },
+   { "position 5",
+     "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     { 44, 1486, 62379, 2103487, 89941194, 0 } },
+   { "position 6",
+     "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     { 46, 2079, 89890, 3894594, 164075551, 0 } }
+};
+const int perftPositionCount = sizeof(perftPositions) / sizeof(perftPositions[0]);
+
+/***************************************************
+ * PERFT
+ * The last ply is counted rather than made
+ ***************************************************/
+uint64_t perft(Board& board, int depth)
+{
+   if (depth <= 0)
+      return 1;
+
+   MoveList moves;
+   generateLegalMoves(board, moves);
+   if (depth == 1)
+      return moves.size();
+
+   uint64_t nodes = 0;
+   for (PackedMove move : moves)
+   {
+      board.makeMove(move);
+      nodes += perft(board, depth - 1);
+      board.unmakeMove();
+   }
+   return nodes;
+}
+
+/***************************************************
+ * PERFT DIVIDE
+ * One line per root move: "e2e4: 20"
+ ***************************************************/
+uint64_t perftDivide(Board& board, int depth, ostream& out)
+{
+   MoveList moves;
+   generateLegalMoves(board, moves);
+
+   uint64_t nodes = 0;
+   for (PackedMove move : moves)
+   {
+      board.makeMove(move);
+      uint64_t count = perft(board, depth - 1);
+      board.unmakeMove();
+      out << move.getCoordinates() << ": " << count << '\n';
+      nodes += count;
+   }
+   out << "\nMoves: " << moves.size() << "\nNodes: " << nodes << endl;
+   return nodes;
+}
+
+/***************************************************
+ * PERFT TASK
+ * Everything below one node: the moves from the root
+ * that reach it and the depth left to count. Nodes
+ * with more than SPLIT_DEPTH left become a task per
+ * move, so idle workers have subtrees to steal; the
+ * rest are counted in place.
+ ***************************************************/
+static const int SPLIT_DEPTH = 3;
+
+struct PerftTask
+{
+   ThreadPool*            pool;
+   const Board*           root;
+   vector<unique_ptr<Board> >* boards;  // one per worker
+   atomic<uint64_t>*      nodes;
+   vector<PackedMove>     path;
+   int                    depth;
+
+   void operator () (int worker)
+   {
+      Board& board = *(*boards)[worker];
+      board = *root;
+      for (size_t i = 0; i < path.size(); i++)
+         board.makeMove(path[i]);
+
+      if (depth <= SPLIT_DEPTH)
+      {
+         nodes->fetch_add(perft(board, depth), memory_order_relaxed);
+         return;
+      }
+
+      MoveList moves;
+      generateLegalMoves(board, moves);
+      for (PackedMove move : moves)
+      {
+         PerftTask child = *this;
+         child.path.push_back(move);
+         child.depth = depth - 1;
+         pool->spawn(worker, child);
+      }
+   }
+};
+
+/***************************************************
+ * PARALLEL PERFT
+ ***************************************************/
+uint64_t parallelPerft(const Board& board, int depth, int threads)
+{
+   if (depth <= SPLIT_DEPTH || threads <= 1)
+   {
+      Board copy(board);
+      return perft(copy, depth);
+   }
+
+   ThreadPool pool(threads);
+   vector<unique_ptr<Board> > boards;
+   for (int i = 0; i < pool.size(); i++)
+      boards.push_back(unique_ptr<Board>(new Board(board)));
+   atomic<uint64_t> nodes(0);
+
+   PerftTask task = { &pool, &board, &boards, &nodes, vector<PackedMove>(), depth };
+   pool.submit(task);
+   pool.wait();
+   return nodes.load();
+}
+
+/***************************************************
+ * PERFT SCALING
+ * The same count with more and more threads, with the
+ * nodes per second overall and per thread
+ ***************************************************/
+void perftScaling(const Board& board, int depth, int maxThreads, ostream& out)
+{
+   for (int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+   {
+      auto start = chrono::steady_clock::now();
+      uint64_t nodes = parallelPerft(board, depth, threads);
+      double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+      uint64_t nps = (uint64_t)(seconds > 0.0 ? nodes / seconds : 0);
+
+      out << "threads " << setw(3) << threads
+          << setw(14) << nodes
+          << fixed << setprecision(3) << setw(10) << seconds << "s"
+          << setw(14) << nps << " nps"
+          << setw(14) << nps / threads << " nps/thread" << endl;
+      if (threads >= maxThreads)
+         break;
+   }
+}
+
+/***************************************************
+ * PERFT SUITE
+ * Every reference position to every depth up to
+ * maxDepth, with the time and nodes per second
+ ***************************************************/
+bool perftSuite(int maxDepth, ostream& out)
+{
+   Board board;
+   bool passed = true;
+   uint64_t totalNodes = 0;
+   double totalSeconds = 0.0;
+
+   for (int i = 0; i < perftPositionCount; i++)
+   {
+      const PerftPosition& position = perftPositions[i];
+      board.loadFEN(position.fen);
+      for (int depth = 1; depth <= maxDepth && depth <= 6; depth++)
+      {
+         uint64_t expected = position.nodes[depth - 1];
+         if (expected == 0)
+            break;
+
+         auto start = chrono::steady_clock::now();
+         uint64_t nodes = perft(board, depth);
+         double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+         totalNodes += nodes;
+         totalSeconds += seconds;
+
+         bool ok = nodes == expected;
+         passed = passed && ok;
+         out << left << setw(12) << position.name << right
+             << " depth " << depth
+             << setw(12) << nodes
+             << (ok ? "  ok  " : "  FAIL expected ")
+             << (ok ? string() : to_string(expected) + "  ")
+             << fixed << setprecision(3) << seconds << "s"
+             << setw(12) << (uint64_t)(seconds > 0.0 ? nodes / seconds : 0) << " nps\n";
+      }
+   }
+
+   out << (passed ? "passed" : "FAILED") << ": " << totalNodes << " nodes in "
+       << fixed << setprecision(3) << totalSeconds << "s, "
+       << (uint64_t)(totalSeconds > 0.0 ? totalNodes / totalSeconds : 0) << " nps" << endl;
+   return passed;
+}
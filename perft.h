@@ -0,0 +1,45 @@
+/***********************************************************************
+ * Header File:
+ *    PERFT : Count the positions reachable from a position
+ * Summary:
+ *    Perft walks every legal move to a fixed depth and counts the
+ *    leaves. The counts for well known positions are published, so a
+ *    mismatch means a bug in move generation or in making and taking
+ *    back moves. Timing the walk measures the speed of both.
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include "board.h"
+#include "moveList.h"
+
+/***************************************************
+ * PERFT POSITION
+ * A reference position and its published leaf counts
+ ***************************************************/
+struct PerftPosition
+{
+   const char* name;
+   const char* fen;
+   uint64_t    nodes[6];  // leaves at depth 1..6, 0 when not worth running
+};
+
+extern const PerftPosition perftPositions[];
+extern const int perftPositionCount;
+
+// leaves at the given depth
+uint64_t perft(Board& board, int depth);
+
+// the same, with the count below each root move written to out
+uint64_t perftDivide(Board& board, int depth, std::ostream& out);
+
+// leaves at the given depth, counted by a pool of threads
+uint64_t parallelPerft(const Board& board, int depth, int threads);
+
+// the parallel count with 1, 2, 4... up to maxThreads threads, timing each
+void perftScaling(const Board& board, int depth, int maxThreads, std::ostream& out);
+
+// run the reference positions up to maxDepth; true when every count matches
+bool perftSuite(int maxDepth, std::ostream& out);
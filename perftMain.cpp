@@ -0,0 +1,103 @@
+/**********************************************************************
+ * PERFT Main file
+ * Count leaf nodes from a position, for testing move generation:
+ *    perft <depth> [fen]        total nodes and nodes per second
+ *    perft divide <depth> [fen] the same, broken down by root move
+ *    perft suite [maxDepth]     the reference positions
+ *    perft parallel <depth> <threads> [fen]
+ *                               the count with 1, 2, 4... threads
+ **********************************************************************/
+
+#include "perft.h"
+#include "board.h"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+/***************************************************
+ * USAGE
+ * Say how to run it, and the exit code for a mistake
+ ***************************************************/
+static int usage()
+{
+   cerr << "usage: perft [divide] <depth> [fen] | perft suite [maxDepth]\n"
+           "       perft parallel <depth> <threads> [fen]\n";
+   return 2;
+}
+
+/***************************************************
+ * READ COUNT
+ * A whole number no smaller than min, and nothing else
+ *    INPUT  text   the argument
+ *           min    the smallest it may be
+ *    OUTPUT value  the number
+ *           return false if the text is not one
+ ***************************************************/
+static bool readCount(const char* text, int min, int& value)
+{
+   char* end = nullptr;
+   errno = 0;
+   long n = strtol(text, &end, 10);
+   if (end == text || *end != '\0' || errno == ERANGE || n < min || n > INT_MAX)
+      return false;
+   value = (int)n;
+   return true;
+}
+
+int main(int argc, char** argv)
+{
+   string command = argc > 1 ? argv[1] : "suite";
+
+   if (command == "suite")
+   {
+      int maxDepth = 4;
+      if (argc > 3 || (argc > 2 && !readCount(argv[2], 1, maxDepth)))
+         return usage();
+      return perftSuite(maxDepth, cout) ? 0 : 1;
+   }
+
+   bool divide = command == "divide";
+   bool parallel = command == "parallel";
+   int arg = divide || parallel ? 2 : 1;
+   int depth = 0;
+   if (arg >= argc || !readCount(argv[arg++], 0, depth))
+      return usage();
+   int threads = 1;
+   if (parallel && arg < argc && !readCount(argv[arg++], 1, threads))
+      return usage();
+
+   // the FEN may arrive as one argument or as six
+   string fen;
+   for (; arg < argc; arg++)
+      fen += string(fen.empty() ? "" : " ") + argv[arg];
+
+   try
+   {
+      Board board;
+      if (!fen.empty())
+         board.loadFEN(fen);
+
+      if (parallel)
+      {
+         perftScaling(board, depth, threads, cout);
+         return 0;
+      }
+
+      auto start = chrono::steady_clock::now();
+      uint64_t nodes = divide ? perftDivide(board, depth, cout) : perft(board, depth);
+      double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      cout << "Nodes: " << nodes << "\nTime: " << seconds << "s\nNPS: "
+           << (uint64_t)(seconds > 0.0 ? nodes / seconds : 0) << endl;
+   }
+   catch (const string& error)
+   {
+      cerr << error << endl;
+      return 2;
+   }
+   return 0;
+}
@@ -0,0 +1,418 @@
+/***********************************************************************
+ * Source File:
+ *    PGN : Read game records in Portable Game Notation
+ * Summary:
+ *    The file is read in batches of chunks, a few per thread, so however
+ *    big the file only two batches of decoded games are held at once:
+ *    the one being handed out and the one being decoded. Each chunk is
+ *    decoded by one task with its own board, straight out of the mapped
+ *    file.
+ ************************************************************************/
+
+#include "pgn.h"
+#include "notation.h"
+#include "threadPool.h"
+#include <memory>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// how much of the file one task decodes
+static const size_t CHUNK_SIZE = 4 << 20;
+
+// how many chunks per thread are decoded before the games are handed out
+static const int CHUNKS_PER_THREAD = 4;
+
+/***************************************************
+ * MAPPED FILE
+ * A read-only view of a whole file in memory. The
+ * operating system pages it in as it is touched
+ ***************************************************/
+class MappedFile
+{
+public:
+   MappedFile(const string& fileName);
+   ~MappedFile();
+
+   string_view getText() const { return string_view(data, size); }
+
+private:
+   MappedFile(const MappedFile&);
+   MappedFile& operator = (const MappedFile&);
+
+   const char* data;
+   size_t      size;
+#if defined(_WIN32)
+   HANDLE      file;
+   HANDLE      mapping;
+#endif
+};
+
+#if defined(_WIN32)
+MappedFile::MappedFile(const string& fileName) : data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+   file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                      FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+   if (file == INVALID_HANDLE_VALUE)
+      throw string("Error reading PGN: cannot open \"") + fileName + "\"";
+   LARGE_INTEGER length;
+   GetFileSizeEx(file, &length);
+   size = (size_t)length.QuadPart;
+   if (size == 0)
+      return;
+   mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if (mapping != nullptr)
+      data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   if (data == nullptr)
+   {
+      if (mapping != nullptr)
+         CloseHandle(mapping);
+      CloseHandle(file);
+      throw string("Error reading PGN: cannot map \"") + fileName + "\"";
+   }
+}
+
+MappedFile::~MappedFile()
+{
+   if (data != nullptr)
+      UnmapViewOfFile(data);
+   if (mapping != nullptr)
+      CloseHandle(mapping);
+   if (file != INVALID_HANDLE_VALUE)
+      CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(const string& fileName) : data(nullptr), size(0)
+{
+   int fd = open(fileName.c_str(), O_RDONLY);
+   if (fd < 0)
+      throw string("Error reading PGN: cannot open \"") + fileName + "\"";
+   struct stat info;
+   if (fstat(fd, &info) == 0)
+      size = (size_t)info.st_size;
+   if (size == 0)
+   {
+      close(fd);
+      return;
+   }
+
+   void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (p == MAP_FAILED)
+      throw string("Error reading PGN: cannot map \"") + fileName + "\"";
+   madvise(p, size, MADV_SEQUENTIAL);
+   data = (const char*)p;
+}
+
+MappedFile::~MappedFile()
+{
+   if (data != nullptr)
+      munmap((void*)data, size);
+}
+#endif
+
+/***************************************************
+ * IS SPACE
+ ***************************************************/
+static bool isSpace(char c)
+{
+   return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+/***************************************************
+ * IS RESULT
+ ***************************************************/
+static bool isResult(string_view token)
+{
+   return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+/***************************************************
+ * NEXT GAME
+ * Where the first game at or after a position starts:
+ * a tag at the start of a line after a blank line.
+ * The end of the text if there is none
+ ***************************************************/
+static size_t nextGame(string_view text, size_t from)
+{
+   for (size_t pos = text.find("\n[", from); pos != string_view::npos; pos = text.find("\n[", pos + 1))
+   {
+      size_t before = pos;
+      while (before > 0 && (text[before - 1] == '\r' || text[before - 1] == ' ' || text[before - 1] == '\t'))
+         before--;
+      if (before > 0 && text[before - 1] == '\n')
+         return pos + 1;
+   }
+   return text.size();
+}
+
+/***************************************************
+ * READ TAG
+ * [Name "Value"] with \" and \\ escaped in the value
+ *    INPUT  text  the text, pos at the '['
+ *    OUTPUT tag   the pair read
+ *           pos   just past the ']' or the line
+ ***************************************************/
+static void readTag(string_view text, size_t& pos, PgnTag& tag)
+{
+   size_t end = text.find('\n', pos);
+   if (end == string_view::npos)
+      end = text.size();
+
+   pos++;
+   while (pos < end && isSpace(text[pos]))
+      pos++;
+   size_t start = pos;
+   while (pos < end && !isSpace(text[pos]) && text[pos] != '"' && text[pos] != ']')
+      pos++;
+   tag.name.assign(text.data() + start, pos - start);
+
+   tag.value.clear();
+   while (pos < end && text[pos] != '"' && text[pos] != ']')
+      pos++;
+   if (pos < end && text[pos] == '"')
+      for (pos++; pos < end && text[pos] != '"'; pos++)
+      {
+         if (text[pos] == '\\' && pos + 1 < end)
+            pos++;
+         tag.value += text[pos];
+      }
+
+   size_t close = text.find(']', pos);
+   pos = close < end ? close + 1 : end;
+}
+
+/***************************************************
+ * DECODE PGN
+ * Go through the text once. A tag after movetext, or
+ * a move after a result, starts the next game.
+ * Comments, variations, NAGs and move numbers are
+ * skipped; everything else must be a legal move
+ *    INPUT  text    PGN, starting at a game
+ *           offset  where the text starts in the file
+ *           board   to play the moves on
+ *    OUTPUT games   the games found are appended here
+ ***************************************************/
+void decodePGN(string_view text, uint64_t offset, Board& board, vector<PgnGame>& games)
+{
+   PgnGame* game = nullptr;
+   bool started = false;   // the board holds the game's position
+   bool inMoves = false;   // the game has had movetext
+   bool failed = false;    // a move could not be played; skip the rest
+
+   size_t pos = 0;
+   while (pos < text.size())
+   {
+      char c = text[pos];
+      if (isSpace(c))
+      {
+         pos++;
+         continue;
+      }
+
+      // comments, escapes and variations
+      if (c == '{')
+      {
+         size_t end = text.find('}', pos);
+         pos = end == string_view::npos ? text.size() : end + 1;
+         continue;
+      }
+      if (c == ';' || (c == '%' && (pos == 0 || text[pos - 1] == '\n')))
+      {
+         size_t end = text.find('\n', pos);
+         pos = end == string_view::npos ? text.size() : end + 1;
+         continue;
+      }
+      if (c == '(')
+      {
+         int depth = 0;
+         for (; pos < text.size(); pos++)
+         {
+            if (text[pos] == '{' || text[pos] == ';')
+            {
+               // comments may hold brackets that are not the variation's
+               size_t end = text.find(text[pos] == '{' ? '}' : '\n', pos);
+               pos = end == string_view::npos ? text.size() - 1 : end;
+            }
+            else if (text[pos] == '(')
+               depth++;
+            else if (text[pos] == ')' && --depth == 0)
+               break;
+         }
+         pos++;
+         continue;
+      }
+
+      if (c == ')')
+      {
+         pos++;
+         continue;
+      }
+
+      // a new game at its first tag, or at movetext after a result
+      bool isTag = c == '[';
+      if (game == nullptr || (isTag && inMoves) || (!isTag && !game->result.empty()))
+      {
+         games.push_back(PgnGame());
+         game = &games.back();
+         game->offset = offset + pos;
+         started = inMoves = failed = false;
+      }
+
+      if (isTag)
+      {
+         game->tags.push_back(PgnTag());
+         readTag(text, pos, game->tags.back());
+         continue;
+      }
+
+      // the next token, less any move number in front of it
+      size_t start = pos;
+      while (pos < text.size() && !isSpace(text[pos]) && text[pos] != '{' && text[pos] != '(' &&
+             text[pos] != ')' && text[pos] != '[' && text[pos] != ';')
+         pos++;
+      string_view token = text.substr(start, pos - start);
+      inMoves = true;
+
+      if (isResult(token))
+      {
+         game->result = string(token);
+         continue;
+      }
+      if (token[0] == '$' || token.find_first_not_of("!?") == string_view::npos)
+         continue;
+      size_t digits = 0;
+      while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9')
+         digits++;
+      if (digits && digits < token.size() && token[digits] == '.')
+      {
+         token.remove_prefix(digits);
+         while (!token.empty() && token.front() == '.')
+            token.remove_prefix(1);
+      }
+      if (token.empty() || failed)
+         continue;
+
+      // set up the position at the first move
+      if (!started)
+      {
+         started = true;
+         const string* fen = game->tag("FEN");
+         try
+         {
+            board.loadFEN(fen != nullptr ? string_view(*fen) : string_view(START_FEN));
+         }
+         catch (const string& error)
+         {
+            game->error = error;
+            failed = true;
+            continue;
+         }
+      }
+
+      PackedMove move;
+      NotationError error = readSAN(board, token, move);
+      if (error != NOTATION_OK)
+      {
+         game->error = string(notationErrorText(error)) + " " + to_string(game->moves.size() / 2 + 1) +
+                       (game->moves.size() % 2 ? "... " : ". ") + string(token);
+         failed = true;
+         continue;
+      }
+      board.makeMove(move);
+      game->moves.push_back(move);
+   }
+}
+
+/***************************************************
+ * SUBMIT BATCH
+ * Split off the next batch of chunks, each ending
+ * where a game starts, and hand one to each task
+ *    INPUT  text    the whole file
+ *           pos     where the batch starts
+ *    OUTPUT pos     where the next batch starts
+ *           chunks  filled with the games as the tasks finish
+ *           return  how many chunks were submitted
+ ***************************************************/
+static int submitBatch(ThreadPool& pool, string_view text, size_t& pos,
+                       vector<vector<PgnGame> >& chunks, vector<unique_ptr<Board> >& boards)
+{
+   int count = 0;
+   for (; count < (int)chunks.size() && pos < text.size(); count++)
+   {
+      size_t end = pos + CHUNK_SIZE < text.size() ? nextGame(text, pos + CHUNK_SIZE) : text.size();
+      string_view chunk = text.substr(pos, end - pos);
+      vector<PgnGame>* games = &chunks[count];
+      uint64_t offset = pos;
+      pool.submit([chunk, offset, games, &boards](int worker)
+      {
+         decodePGN(chunk, offset, *boards[worker], *games);
+      });
+      pos = end;
+   }
+   return count;
+}
+
+/***************************************************
+ * READ PGN
+ * Map the file, then decode it a batch of chunks at
+ * a time, one task per chunk. While the workers decode
+ * one batch, the games of the batch before are handed
+ * out in order on this thread
+ ***************************************************/
+PgnStats readPGN(const string& fileName, int threads, const PgnCallback& onGame)
+{
+   MappedFile file(fileName);
+   string_view text = file.getText();
+
+   PgnStats stats;
+   stats.bytes = text.size();
+
+   // declared before the pool, so the pool finishes its tasks before
+   // these go away, even if a callback throws
+   int workers = threads < 1 ? 1 : threads;
+   int batchSize = workers * CHUNKS_PER_THREAD;
+   vector<unique_ptr<Board> > boards;
+   for (int i = 0; i < workers; i++)
+      boards.push_back(unique_ptr<Board>(new Board));
+   vector<vector<PgnGame> > batches[2] = { vector<vector<PgnGame> >(batchSize),
+                                           vector<vector<PgnGame> >(batchSize) };
+   ThreadPool pool(workers);
+
+   size_t pos = 0;
+   int current = 0;
+   int count = submitBatch(pool, text, pos, batches[current], boards);
+   pool.wait();
+   while (count > 0)
+   {
+      int following = submitBatch(pool, text, pos, batches[1 - current], boards);
+
+      for (int i = 0; i < count; i++)
+      {
+         for (const PgnGame& game : batches[current][i])
+         {
+            stats.games++;
+            stats.moves += game.moves.size();
+            if (!game.error.empty())
+               stats.errors++;
+            onGame(game);
+         }
+         batches[current][i].clear();
+      }
+
+      pool.wait();
+      current = 1 - current;
+      count = following;
+   }
+   return stats;
+}
@@ -0,0 +1,78 @@
+/***********************************************************************
+ * Header File:
+ *    PGN : Read game records in Portable Game Notation
+ * Summary:
+ *    A PGN file is game after game, each a block of tag pairs such as
+ *    [White "Carlsen, Magnus"] followed by the moves in SAN. Dumps run to
+ *    gigabytes, so the file is mapped into memory rather than read, cut
+ *    into chunks at game boundaries, and the chunks decoded on a thread
+ *    pool. Every move is checked against the legal moves of the position
+ *    it is played from. The games come back in the order of the file.
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "board.h"
+#include "packedMove.h"
+
+/***************************************************
+ * PGN TAG
+ * One tag pair, with any escapes taken out
+ ***************************************************/
+struct PgnTag
+{
+   std::string name;
+   std::string value;
+};
+
+/***************************************************
+ * PGN GAME
+ * One game as decoded. A game with a move that is
+ * not legal keeps the moves before it
+ ***************************************************/
+struct PgnGame
+{
+   PgnGame() : offset(0) {}
+
+   uint64_t                offset;  // where the game starts in the file
+   std::vector<PgnTag>     tags;    // in the order they appear
+   std::vector<PackedMove> moves;   // from the FEN tag's position, or the start
+   std::string             result;  // "1-0", "0-1", "1/2-1/2", "*" or empty
+   std::string             error;   // empty if every move was read and legal
+
+   // the value of a tag, nullptr if the game does not have it
+   const std::string* tag(std::string_view name) const
+   {
+      for (const PgnTag& t : tags)
+         if (t.name == name)
+            return &t.value;
+      return nullptr;
+   }
+};
+
+/***************************************************
+ * PGN STATS
+ ***************************************************/
+struct PgnStats
+{
+   PgnStats() : games(0), moves(0), errors(0), bytes(0) {}
+
+   uint64_t games;
+   uint64_t moves;
+   uint64_t errors;  // games with a move that could not be played
+   uint64_t bytes;
+};
+
+typedef std::function<void(const PgnGame&)> PgnCallback;
+
+// decode every game in a file, handing each to the callback on this
+// thread in the order of the file. Throws a string if it cannot be read
+PgnStats readPGN(const std::string& fileName, int threads, const PgnCallback& onGame);
+
+// decode the games in some PGN text, using the board to play the moves
+void decodePGN(std::string_view text, uint64_t offset, Board& board, std::vector<PgnGame>& games);
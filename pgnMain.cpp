@@ -0,0 +1,46 @@
+/**********************************************************************
+ * PGN Main file
+ * Read a PGN file and check every move of every game:
+ *    pgn <file> [threads]   count the games and moves, list the games
+ *                           with moves that could not be played, and
+ *                           time the whole read
+ **********************************************************************/
+
+#include "pgn.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+   if (argc < 2)
+   {
+      cerr << "usage: pgn <file> [threads]\n";
+      return 2;
+   }
+   int threads = argc > 2 ? atoi(argv[2]) : (int)thread::hardware_concurrency();
+
+   try
+   {
+      auto start = chrono::steady_clock::now();
+      PgnStats stats = readPGN(argv[1], threads, [](const PgnGame& game)
+      {
+         if (!game.error.empty())
+            cerr << "game at byte " << game.offset << ": " << game.error << '\n';
+      });
+      double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      cout << "Games: " << stats.games << "\nMoves: " << stats.moves
+           << "\nErrors: " << stats.errors << "\nTime: " << seconds << "s\nMB/s: "
+           << (seconds > 0.0 ? stats.bytes / seconds / (1 << 20) : 0.0) << endl;
+      return stats.errors ? 1 : 0;
+   }
+   catch (const string& error)
+   {
+      cerr << error << endl;
+      return 2;
+   }
+}
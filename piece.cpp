@@ -4,6 +4,7 @@
  ************************************************************************/
 
 #include "piece.h"
+#include "attacks.h"
 #define NDEBUG
 #include <cassert>
 
@@ -34,6 +35,10 @@ const Position Piece::getPosition() const {
     return position;
 }
 
+int Piece::getLastMove() const {
+    return lastMove;
+}
+
 void Piece::setLastMove(int currentMove) {
     lastMove = currentMove;
 }
@@ -64,6 +69,42 @@ char Piece::getLetter() const {
     }
 }
 
+/**************************************************************
+ * PIECE : GET MOVES INTO A SET
+ * Collect the moves of this piece into a sorted set, used by the
+ * display to highlight the possible destinations.
+ * INPUT: board - the board the piece is on
+ * OUTPUT: possible - the set the moves are added to
+ *************************************************************/
+void Piece::getMoves(set<Move>& possible, const Board& board) const {
+    MoveList moves;
+    getMoves(moves, board);
+    for (PackedMove move : moves)
+        possible.insert(move.toMove(board));
+}
+
+/**************************************************************
+ * PIECE : ADD MOVES
+ * Add a move to each target square, flagging the ones that
+ * land on an opponent's piece as captures.
+ * INPUT: board   - the board the piece is on
+ *        targets - the squares this piece can move to
+ *        gen     - which of those moves are wanted
+ * OUTPUT: moves  - the list the moves are added to
+ *************************************************************/
+void Piece::addMoves(MoveList& moves, const Board& board, Bitboard targets, GenType gen) const {
+    Bitboard enemy = board.getColour(!isWhite);
+    if (gen == GEN_CAPTURES)
+        targets &= enemy;
+    else if (gen == GEN_QUIETS)
+        targets &= ~enemy;
+    int src = position.getLocation();
+    while (targets) {
+        int des = popLsb(targets);
+        moves.add(PackedMove(src, des, (enemy & squareBB(des)) ? MOVE_CAPTURE : MOVE_QUIET));
+    }
+}
+
 /**************************************************************
  * PIECE : ASSIGNMENT OPERATOR OVERLOAD (PIECE)
  * Assign one Piece object to another.
@@ -123,234 +164,130 @@ bool Piece::operator!=(const Piece& other) const {
   **************************************/
 Space::Space(int row, int col) : Piece(PieceType::SPACE, false, row, col) {}
 
-void Space::getMoves(set<Move>& possible, const Board& board) const {} // Space has no moves
-void Space::display(ogstream* pgout) const {} // Space has no graphic
+void Space::getMoves(MoveList& moves, const Board& board, GenType gen) const {} // Space has no moves
 
 // KING
 King::King(int row, int col, bool isWhite) : Piece(KING, isWhite, row, col) {}
 
-void King::getMoves(set<Move>& possible, const Board& board) const {
-    static const vector<pair<int, int>> kingMoves = {
-        {0, 1}, {1, 0}, {1, 1},
-        {0, -1}, {-1, 0}, {-1, -1},
-        {1, -1}, {-1, 1}
-    };
+void King::getMoves(MoveList& moves, const Board& board, GenType gen) const {
     int row = position.getRow();
     int col = position.getCol();
+    Bitboard occupied = board.getOccupied();
 
-    for (const auto& move : kingMoves) {
-        int newRow = row + move.first;
-        int newCol = col + move.second;
-        if (newRow >= 0 && newRow < 8 && newCol >= 0 && newCol < 8) {
-            const Piece* targetPiece = &board[Position(newRow, newCol)];
-            if (targetPiece->getLetter() == ' ' || targetPiece->getIsWhite() != isWhite) {
-                possible.insert(Move(position, Position(newRow, newCol)));
-            }
-        }
-    }
+    // One step in any direction, to a square that is empty or holds an opponent's piece
+    Bitboard targets = kingAttacks[position.getLocation()] & ~board.getColour(isWhite);
+    addMoves(moves, board, targets, gen);
 
-    // Check if the squares between the king and the rooks are empty
-    bool canCastleKingSide = board[Position(row, col + 1)].getPieceType() == SPACE &&
-        board[Position(row, col + 2)].getPieceType() == SPACE;
-
-    bool canCastleQueenSide = board[Position(row, col - 1)].getPieceType() == SPACE &&
-        board[Position(row, col - 2)].getPieceType() == SPACE &&
-        board[Position(row, col - 3)].getPieceType() == SPACE;
-
-    // Iterate over adjacent squares and add valid moves
-    for (int dr = -1; dr <= 1; ++dr) {
-        for (int dc = -1; dc <= 1; ++dc) {
-            if (dr != 0 || dc != 0) { // Exclude the king's current position
-                int newRow = row + dr;
-                int newCol = col + dc;
-                if (newRow >= 0 && newRow < 8 && newCol >= 0 && newCol < 8) {
-                    const Piece* targetPiece = &board[Position(newRow, newCol)];
-                    if (targetPiece->getPieceType() == SPACE || targetPiece->getIsWhite() != isWhite) {
-                        possible.insert(Move(position, Position(newRow, newCol)));
-                    }
-                }
-            }
-        }
-    }
+    // Check that neither the king nor the rook has moved, and that the
+    // squares between them are empty
+    unsigned char rights = board.getCastling();
+    bool canCastleKingSide = (rights & (isWhite ? CASTLE_WHITE_K : CASTLE_BLACK_K)) && col + 2 < 8 &&
+        !(occupied & (squareBB(row * 8 + col + 1) | squareBB(row * 8 + col + 2)));
+
+    bool canCastleQueenSide = (rights & (isWhite ? CASTLE_WHITE_Q : CASTLE_BLACK_Q)) && col - 3 >= 0 &&
+        !(occupied & (squareBB(row * 8 + col - 1) | squareBB(row * 8 + col - 2) |
+                      squareBB(row * 8 + col - 3)));
 
     // Add castling moves if conditions are met
+    int src = position.getLocation();
+    if (gen == GEN_CAPTURES)
+        return;
     if (canCastleKingSide) {
-        possible.insert(Move(position, Position(row, col + 2), KING));
+        moves.add(PackedMove(src, src + 2, MOVE_CASTLE_K));
     }
     if (canCastleQueenSide) {
-        possible.insert(Move(position, Position(row, col - 2), KING));
+        moves.add(PackedMove(src, src - 2, MOVE_CASTLE_Q));
     }
 }
 
-void King::display(ogstream* pgout) const {
-    pgout->drawKing(position.getLocation(), isWhite);
-}
-
 // QUEEN
 Queen::Queen(int row, int col, bool isWhite) : Piece(QUEEN, isWhite, row, col) {}
 
-void Queen::getMoves(set<Move>& possible, const Board& board) const {
-    // Combine Rook and Bishop directions
-    vector<pair<int, int>> directions = { {-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
-    int row = position.getRow(), col = position.getCol();
-
-    for (const auto& dir : directions) {
-        int nextRow = row, nextCol = col;
-        while (true) {
-            nextRow += dir.first;
-            nextCol += dir.second;
-            if (nextRow < 0 || nextRow >= 8 || nextCol < 0 || nextCol >= 8) break;
-            const Piece& target = board[Position(nextRow, nextCol)];
-            if (target.getPieceType() == SPACE) {
-                possible.insert(Move(position, Position(nextRow, nextCol)));
-            }
-            else {
-                if (target.getIsWhite() != isWhite) {
-                    possible.insert(Move(position, Position(nextRow, nextCol)));
-                }
-                break;
-            }
-        }
-    }
-}
-
-void Queen::display(ogstream* pgout) const {
-    pgout->drawQueen(position.getLocation(), isWhite);
+void Queen::getMoves(MoveList& moves, const Board& board, GenType gen) const {
+    // Both the rook and the bishop rays, stopping at and including the first blocker
+    Bitboard targets = queenAttacks(position.getLocation(), board.getOccupied()) & ~board.getColour(isWhite);
+    addMoves(moves, board, targets, gen);
 }
 
 // ROOK
 Rook::Rook(int row, int col, bool isWhite) : Piece(ROOK, isWhite, row, col) {}
 
-void Rook::getMoves(set<Move>& possible, const Board& board) const {
-    // Directions: up, down, left, right
-    vector<pair<int, int>> directions = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
-    int row = position.getRow(), col = position.getCol();
-
-    for (const auto& dir : directions) {
-        int nextRow = row, nextCol = col;
-        while (true) {
-            nextRow += dir.first;
-            nextCol += dir.second;
-            if (nextRow < 0 || nextRow >= 8 || nextCol < 0 || nextCol >= 8) break; // Out of bounds
-            const Piece& target = board[Position(nextRow, nextCol)];
-            if (target.getPieceType() == SPACE) { // Empty space
-                possible.insert(Move(position, Position(nextRow, nextCol)));
-            }
-            else {
-                if (target.getIsWhite() != isWhite) { // Capture
-                    possible.insert(Move(position, Position(nextRow, nextCol)));
-                }
-                break; // Blocked by a piece
-            }
-        }
-    }
-}
-
-void Rook::display(ogstream* pgout) const {
-    pgout->drawRook(position.getLocation(), isWhite);
+void Rook::getMoves(MoveList& moves, const Board& board, GenType gen) const {
+    // Up, down, left and right, stopping at and including the first blocker
+    Bitboard targets = rookAttacks(position.getLocation(), board.getOccupied()) & ~board.getColour(isWhite);
+    addMoves(moves, board, targets, gen);
 }
 
 // BISHOP
 Bishop::Bishop(int row, int col, bool isWhite) : Piece(BISHOP, isWhite, row, col) {}
 
-void Bishop::getMoves(set<Move>& possible, const Board& board) const {
-    // Directions: diagonals
-    vector<pair<int, int>> directions = { {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
-    int row = position.getRow(), col = position.getCol();
-
-    for (const auto& dir : directions) {
-        int nextRow = row, nextCol = col;
-        while (true) {
-            nextRow += dir.first;
-            nextCol += dir.second;
-            if (nextRow < 0 || nextRow >= 8 || nextCol < 0 || nextCol >= 8) break;
-            const Piece& target = board[Position(nextRow, nextCol)];
-            if (target.getPieceType() == SPACE) {
-                possible.insert(Move(position, Position(nextRow, nextCol)));
-            }
-            else {
-                if (target.getIsWhite() != isWhite) {
-                    possible.insert(Move(position, Position(nextRow, nextCol)));
-                }
-                break;
-            }
-        }
-    }
-}
-
-void Bishop::display(ogstream* pgout) const {
-    pgout->drawBishop(position.getLocation(), isWhite);
+void Bishop::getMoves(MoveList& moves, const Board& board, GenType gen) const {
+    // The four diagonals, stopping at and including the first blocker
+    Bitboard targets = bishopAttacks(position.getLocation(), board.getOccupied()) & ~board.getColour(isWhite);
+    addMoves(moves, board, targets, gen);
 }
 
 // KNIGHT
 Knight::Knight(int row, int col, bool isWhite) : Piece(KNIGHT, isWhite, row, col) {}
 
-void Knight::getMoves(set<Move>& possible, const Board& board) const {
-    // Current position of the knight
-    int row = position.getRow();
-    int col = position.getCol();
-
-    // Define the knight's possible moves relative to its current position
-    static const vector<pair<int, int>> knightMoves = {
-        {-1, -2}, {-2, -1}, 
-        {-2,  1},        {-1,  2},
-        {1,  -2},        {2,  -1}, 
-        {2,   1}, {1,   2}
-    };
-
-    // Iterate over possible moves and check if they are valid
-    for (const auto& move : knightMoves) {
-        int newRow = row + move.first;
-        int newCol = col + move.second;
-
-        // Check if the new position is within the board bounds
-        if (newRow >= 0 && newRow < 8 && newCol >= 0 && newCol < 8) {
-            const Piece* targetPiece = &board[Position(newRow, newCol)];
-            if (targetPiece->getLetter() == ' ' || targetPiece->getIsWhite() != isWhite) {
-                // If the target square is empty or contains an opponent's piece, add the move
-                possible.insert(Move(position, Position(newRow, newCol)));
-            }
-        }
-    }
-}
-
-void Knight::display(ogstream* pgout) const {
-    pgout->drawKnight(position.getLocation(), isWhite);
+void Knight::getMoves(MoveList& moves, const Board& board, GenType gen) const {
+    // The eight L-shaped jumps that stay on the board, to a square that is
+    // empty or contains an opponent's piece
+    Bitboard targets = knightAttacks[position.getLocation()] & ~board.getColour(isWhite);
+    addMoves(moves, board, targets, gen);
 }
 
 // PAWN
 Pawn::Pawn(int row, int col, bool isWhite) : Piece(PAWN, isWhite, row, col) {}
 
-void Pawn::getMoves(set<Move>& possible, const Board& board) const {
-    int direction = isWhite ? -1 : 1; // Adjust direction based on pawn color
-    int startRow = isWhite ? 6 : 1; // Starting rows differ based on color
+// A pawn move, or all four promotions when it reaches the far row
+static void addPawnMove(MoveList& moves, int src, int des, bool promote, bool capture) {
+    if (promote) {
+        moves.add(PackedMove(src, des, PackedMove::promoteFlag(QUEEN,  capture)));
+        moves.add(PackedMove(src, des, PackedMove::promoteFlag(ROOK,   capture)));
+        moves.add(PackedMove(src, des, PackedMove::promoteFlag(BISHOP, capture)));
+        moves.add(PackedMove(src, des, PackedMove::promoteFlag(KNIGHT, capture)));
+    }
+    else {
+        moves.add(PackedMove(src, des, capture ? MOVE_CAPTURE : MOVE_QUIET));
+    }
+}
+
+void Pawn::getMoves(MoveList& moves, const Board& board, GenType gen) const {
+    int direction = isWhite ? 1 : -1; // Adjust direction based on pawn color
+    int startRow = isWhite ? 1 : 6; // Starting rows differ based on color
+    int lastRow = isWhite ? 7 : 0; // Pawns promote on the far row
     int row = position.getRow();
     int col = position.getCol();
-
-    // Forward one space
-    if (board[Position(row + direction, col)].getPieceType() == SPACE) {
-        possible.insert(Move(position, Position(row + direction, col)));
+    int src = position.getLocation();
+    Bitboard occupied = board.getOccupied();
+    Bitboard enemy = board.getColour(!isWhite);
+
+    if (row + direction < 0 || row + direction >= 8)
+        return;
+    bool promote = (row + direction == lastRow);
+
+    // Forward one space; a promotion counts as a capture
+    int des = (row + direction) * 8 + col;
+    if (!(occupied & squareBB(des)) && (gen == GEN_ALL || (gen == GEN_CAPTURES) == promote)) {
+        addPawnMove(moves, src, des, promote, false);
         // Double move from start position
-        if (row == startRow && board[Position(row + 2 * direction, col)].getPieceType() == SPACE) {
-            possible.insert(Move(position, Position(row + 2 * direction, col)));
+        if (row == startRow && !(occupied & squareBB((row + 2 * direction) * 8 + col))) {
+            moves.add(PackedMove(src, (row + 2 * direction) * 8 + col));
         }
     }
-
-    // En-passant
-    if (!board.getMoveHistory().empty()) {
-        // Check if the move meets the conditions for en passant
-        const Move& lastMove = board.getLastMove();
-        if (board[lastMove.getDes()].getPieceType() == PAWN &&
-            abs(lastMove.getDes().getCol() - col) == 1 &&
-            abs(lastMove.getDes().getRow() == row &&
-            abs(lastMove.getSrc().getRow() - row) == 2))
-        {
-            // Add en passant move to the possible set
-            possible.insert(Move(position, Position(row + direction, lastMove.getDes().getCol())));
-        }
+    if (gen == GEN_QUIETS)
+        return;
+
+    // Capture diagonally forward
+    if (col > 0 && (enemy & squareBB(des - 1)))
+        addPawnMove(moves, src, des - 1, promote, true);
+    if (col < 7 && (enemy & squareBB(des + 1)))
+        addPawnMove(moves, src, des + 1, promote, true);
+
+    // En-passant onto the square the opponent's pawn just skipped
+    int enPassant = board.getEnPassant();
+    if (enPassant >= 0 && enPassant / 8 == row + direction && abs(enPassant % 8 - col) == 1) {
+        moves.add(PackedMove(src, enPassant, MOVE_EN_PASSANT));
     }
 }
-
-void Pawn::display(ogstream* pgout) const {
-    pgout->drawPawn(position.getLocation(), isWhite);
-}
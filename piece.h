@@ -4,7 +4,8 @@
 #include "board.h"
 #include "position.h"
 #include "move.h"
-#include "uiDraw.h"
+#include "moveList.h"
+#include "bitboard.h"
 #include <vector>
 #include <set>
 
@@ -22,8 +23,9 @@ public:
     bool getIsWhite() const;
     char getLetter() const;
     const Position getPosition() const;
-    virtual void getMoves(set<Move>& possible, const Board& board) const = 0;
-    virtual void display(ogstream* pgout) const = 0;
+    int getLastMove() const;
+    void getMoves(set<Move>& possible, const Board& board) const;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const = 0;
 
     // setters
     void setLastMove(int currentMove);
@@ -33,6 +35,8 @@ public:
     bool operator!=(const Piece& other) const;
 
 protected:
+    void addMoves(MoveList& moves, const Board& board, Bitboard targets, GenType gen) const;
+
     PieceType type;
     bool isWhite;
     Position position;
@@ -42,49 +46,49 @@ protected:
 class Space : public Piece {
 public:
     Space(int row, int col);
-    virtual void getMoves(set<Move>& possible, const Board& board) const override;
-    virtual void display(ogstream* pgout) const override;
+    using Piece::getMoves;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const override;
 };
 
 class King : public Piece {
 public:
     King(int row, int col, bool isWhite);
-    virtual void getMoves(set<Move>& possible, const Board& board) const override;
-    virtual void display(ogstream* pgout) const override;
+    using Piece::getMoves;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const override;
 };
 
 class Queen : public Piece {
 public:
     Queen(int row, int col, bool isWhite);
-    virtual void getMoves(set<Move>& possible, const Board& board) const override;
-    virtual void display(ogstream* pgout) const override;
+    using Piece::getMoves;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const override;
 };
 
 class Rook : public Piece {
 public:
     Rook(int row, int col, bool isWhite);
-    virtual void getMoves(set<Move>& possible, const Board& board) const override;
-    virtual void display(ogstream* pgout) const override;
+    using Piece::getMoves;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const override;
 };
 
 class Bishop : public Piece {
 public:
     Bishop(int row, int col, bool isWhite);
-    virtual void getMoves(set<Move>& possible, const Board& board) const override;
-    virtual void display(ogstream* pgout) const override;
+    using Piece::getMoves;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const override;
 };
 
 class Knight : public Piece {
 public:
     Knight(int row, int col, bool isWhite);
-    virtual void getMoves(set<Move>& possible, const Board& board) const override;
-    virtual void display(ogstream* pgout) const override;
+    using Piece::getMoves;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const override;
 };
 
 class Pawn : public Piece {
 public:
     Pawn(int row, int col, bool isWhite);
-    virtual void getMoves(set<Move>& possible, const Board& board) const override;
-    virtual void display(ogstream* pgout) const override;
+    using Piece::getMoves;
+    virtual void getMoves(MoveList& moves, const Board& board, GenType gen = GEN_ALL) const override;
 };
 
@@ -0,0 +1,25 @@
+/***********************************************************************
+ * Header File:
+ *    PSQT : Piece-square tables
+ * Summary:
+ *    What a piece is worth on each square, once for the middlegame and
+ *    once for the endgame. The worth includes the piece's material, and
+ *    black's entries are negated so a position's totals are simply the
+ *    sum over its pieces. The Board keeps those sums current the same
+ *    way it keeps its Zobrist key, so the evaluation never scans the
+ *    board. The game phase, from the pieces left, blends the two.
+ ************************************************************************/
+
+#pragma once
+
+#include "pieceType.h"
+
+extern int psqMg[2][7][64];   // indexed by [isWhite][PieceType][square]
+extern int psqEg[2][7][64];
+
+// how much each piece type counts toward the middlegame
+const int PHASE_WEIGHT[7] = { 0, 0, 4, 2, 1, 1, 0 };
+const int PHASE_MAX = 24;     // the phase of the starting position
+
+// build the tables. Safe to call more than once
+void initPSQT();
@@ -0,0 +1,618 @@
+/***********************************************************************
+ * Source File:
+ *    SEARCH : Choose a move
+ * Summary:
+ *    Each thread has a Searcher that plays moves on its own copy of the
+ *    board. Every node records the best line below it in a triangular
+ *    table, so the principal variation falls out of the root's row.
+ *    The Searchers outlive a single search so their boards are reused.
+ ************************************************************************/
+
+#include "search.h"
+#include "movegen.h"
+#include "eval.h"
+#include "transposition.h"
+#include "moveOrder.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#define NDEBUG
+#include <cassert>
+
+using namespace std;
+
+static TranspositionTable tt;
+
+// a capture that cannot lift the score this close to alpha is not searched
+static const int DELTA_MARGIN = 200;
+
+// half the first aspiration window around the last iteration's score
+static const int ASPIRATION_WINDOW = 25;
+
+// how far the static evaluation may be off per ply of depth near the leaves
+static const int FUTILITY_MARGIN = 120;
+static const int FUTILITY_DEPTH  = 3;
+static atomic<bool> stopFlag(false);
+
+/***************************************************
+ * SKIP DEPTH
+ * Helper threads skip a pattern of depths so they are
+ * not all working on the same iteration. Patterns
+ * repeat every twenty helpers
+ ***************************************************/
+static bool skipDepth(int thread, int depth)
+{
+   static const int SKIP_SIZE[20]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+   static const int SKIP_PHASE[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+   if (thread == 0)
+      return false;
+   int i = (thread - 1) % 20;
+   return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2 != 0;
+}
+
+/***************************************************
+ * REDUCTION
+ * How many plies less a late move is searched. Grows
+ * with the log of the depth and of how many moves came
+ * before it, since a move the ordering put late is
+ * unlikely to be best
+ ***************************************************/
+static int reduction(int depth, int moveCount)
+{
+   static const struct Table
+   {
+      int r[MAX_DEPTH + 1][MAX_MOVES];
+      Table()
+      {
+         for (int d = 0; d <= MAX_DEPTH; d++)
+            for (int m = 0; m < MAX_MOVES; m++)
+               r[d][m] = (d && m) ? (int)(0.75 + log((double)d) * log((double)m) / 2.25) : 0;
+      }
+   } table;
+   return table.r[depth < MAX_DEPTH ? depth : MAX_DEPTH][moveCount < MAX_MOVES ? moveCount : MAX_MOVES - 1];
+}
+
+/***************************************************
+ * MATE SCORES IN THE TABLE
+ * Mate scores count plies from the root, but the
+ * table is shared between positions at any ply, so
+ * they are stored counting from the position itself
+ ***************************************************/
+static int scoreToTT(int score, int ply)
+{
+   return score >= SCORE_MATE_IN_MAX ? score + ply : score <= -SCORE_MATE_IN_MAX ? score - ply : score;
+}
+
+static int scoreFromTT(int score, int ply)
+{
+   return score >= SCORE_MATE_IN_MAX ? score - ply : score <= -SCORE_MATE_IN_MAX ? score + ply : score;
+}
+
+/***************************************************
+ * SEARCHER
+ * The state of one search thread
+ ***************************************************/
+class Searcher
+{
+public:
+   Searcher(int id) : id(id), nodes(0), aborted(false), rootDepth(0) {}
+
+   void run(const Board& root, const Limits& limits, chrono::steady_clock::time_point start,
+            const SearchCallback& onIteration);
+   const SearchResult& getResult() const { return result; }
+   uint64_t getNodes() const { return nodes.load(memory_order_relaxed); }
+
+private:
+   int negamax(int depth, int ply, int alpha, int beta);
+   int quiescence(int ply, int alpha, int beta);
+   bool shouldStop();
+   void extendPV();
+   void report(const SearchCallback& onIteration);
+   int64_t elapsed() const
+   {
+      return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+   }
+
+   int id;                    // 0 for the main thread, which keeps time
+   Board board;
+   Limits limits;
+   atomic<uint64_t> nodes;    // read by the main thread for the node limit
+   bool aborted;
+   int rootDepth;
+   PackedMove rootBest;
+   Heuristics heuristics;     // move ordering learned during this search
+   SearchResult result;
+   chrono::steady_clock::time_point start;
+   PackedMove pv[MAX_DEPTH + 1][MAX_DEPTH + 1];  // pv[ply] is the best line from ply
+   int pvLength[MAX_DEPTH + 1];
+
+   // telemetry, read only by this thread
+   int selDepth;
+   uint64_t ttProbes;
+   uint64_t ttHits;
+   uint64_t cutoffs;
+   uint64_t firstMoveCutoffs;
+   uint64_t researches;
+   uint64_t aspirationResearches;
+};
+
+static vector<unique_ptr<Searcher> > searchers;
+
+/***************************************************
+ * SEARCHER : SHOULD STOP
+ * The first iteration always finishes so there is a
+ * move to play. Only the main thread watches the
+ * limits; it tells the helpers through the stop flag
+ ***************************************************/
+bool Searcher::shouldStop()
+{
+   if (aborted)
+      return true;
+   if (rootDepth <= 1)
+      return false;
+
+   if (stopFlag.load(memory_order_relaxed))
+      aborted = true;
+   else if (id == 0 && (getNodes() & 1023) == 0)
+   {
+      uint64_t total = 0;
+      for (size_t i = 0; i < searchers.size(); i++)
+         total += searchers[i]->getNodes();
+      if ((limits.nodes && total >= limits.nodes) ||
+          (limits.movetime && elapsed() >= limits.movetime))
+      {
+         stopFlag.store(true, memory_order_relaxed);
+         aborted = true;
+      }
+   }
+   return aborted;
+}
+
+/***************************************************
+ * SEARCHER : NEGAMAX
+ * The score of the position for the side to move,
+ * exact when it falls between alpha and beta. Away
+ * from the principal variation, positions far from
+ * the window are cut short and late quiet moves are
+ * searched less deeply
+ *    INPUT depth  plies left to search
+ *          ply    plies from the root
+ ***************************************************/
+int Searcher::negamax(int depth, int ply, int alpha, int beta)
+{
+   pvLength[ply] = ply;
+   if (shouldStop())
+      return 0;
+   nodes.store(nodes.load(memory_order_relaxed) + 1, memory_order_relaxed);
+   if (ply > selDepth)
+      selDepth = ply;
+
+   if (ply > 0 && board.isDraw())
+      return 0;
+   if (depth <= 0 || ply >= MAX_DEPTH)
+      return quiescence(ply, alpha, beta);
+
+   // another thread, or an earlier iteration, may have the answer
+   TTEntry entry;
+   PackedMove ttMove;
+   bool ttHit = tt.probe(board.getKey(), entry);
+   ttProbes++;
+   if (ttHit)
+   {
+      ttHits++;
+      ttMove = entry.move;
+      int score = scoreFromTT(entry.score, ply);
+      if (ply > 0 && entry.depth >= depth &&
+          (entry.bound == BOUND_EXACT ||
+           (entry.bound == BOUND_LOWER && score >= beta) ||
+           (entry.bound == BOUND_UPPER && score <= alpha)))
+         return score;
+   }
+
+   // a window wider than one means this node may be on the principal
+   // variation, so nothing is pruned here
+   bool pvNode = beta - alpha > 1;
+   bool inCheck = board.inCheck();
+   int staticEval = 0;
+   if (!inCheck)
+      staticEval = ttHit ? entry.eval : evaluate(board);
+
+   if (!pvNode && !inCheck && ply > 0 && abs(beta) < SCORE_MATE_IN_MAX)
+   {
+      // reverse futility: so far above beta that a few plies will not undo it
+      if (depth <= FUTILITY_DEPTH && staticEval - FUTILITY_MARGIN * depth >= beta)
+         return staticEval;
+
+      // null move: if passing still fails high, a real move surely would.
+      // Not with only pawns left, where passing may be the best move
+      if (depth >= 3 && staticEval >= beta && !board.getPreviousMove().isNull() &&
+          (board.getColour(board.whiteTurn()) & ~board.getPieces(board.whiteTurn(), PAWN)
+                                              & ~board.getPieces(board.whiteTurn(), KING)))
+      {
+         int r = 3 + depth / 6;
+         board.makeNullMove();
+         int score = -negamax(depth - 1 - r, ply + 1, -beta, -beta + 1);
+         board.unmakeNullMove();
+         if (aborted)
+            return 0;
+         if (score >= beta)
+            return score >= SCORE_MATE_IN_MAX ? beta : score;
+      }
+   }
+
+   // the best move of the last iteration is most likely best again
+   MovePicker picker(board, heuristics, ply == 0 ? rootBest : ttMove, ply);
+   if (picker.size() == 0)
+      return inCheck ? -SCORE_MATE + ply : 0;
+
+   // quiet moves here cannot lift a hopeless evaluation to alpha
+   bool futile = !pvNode && !inCheck && depth <= FUTILITY_DEPTH &&
+                 staticEval + FUTILITY_MARGIN * depth <= alpha;
+
+   int alphaOriginal = alpha;
+   int best = -SCORE_INFINITE;
+   PackedMove bestMove;
+   PackedMove quiets[MAX_MOVES];
+   int quietCount = 0;
+   int moveCount = 0;
+   PackedMove move;
+   while (picker.next(move))
+   {
+      bool quiet = !move.isCapture() && !move.isPromotion();
+      if (futile && quiet && best > -SCORE_MATE_IN_MAX)
+         continue;
+      moveCount++;
+
+      board.makeMove(move);
+      int score;
+
+      // principal variation search: the first move is expected to be
+      // best, so the others only have to be shown no better with a null
+      // window. Late quiet moves are also searched shallower. A move that
+      // beats alpha after all is searched again in full
+      if (moveCount == 1)
+         score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+      else
+      {
+         int r = 0;
+         if (depth >= 3 && moveCount > 3 && quiet && !inCheck && !board.inCheck())
+         {
+            r = reduction(depth, moveCount) - (pvNode ? 1 : 0)
+              - heuristics.history[!board.whiteTurn()][move.getSrc()][move.getDes()] / (Heuristics::HISTORY_MAX / 2);
+            r = r < 0 ? 0 : r > depth - 2 ? depth - 2 : r;
+         }
+         score = -negamax(depth - 1 - r, ply + 1, -alpha - 1, -alpha);
+         if (score > alpha && r > 0 && !aborted)
+         {
+            researches++;
+            score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha);
+         }
+         if (score > alpha && score < beta && !aborted)
+         {
+            researches++;
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+         }
+      }
+      board.unmakeMove();
+      if (aborted)
+         return 0;
+
+      if (score > best)
+      {
+         best = score;
+         bestMove = move;
+         if (score > alpha)
+         {
+            alpha = score;
+            pv[ply][ply] = move;
+            for (int i = ply + 1; i < pvLength[ply + 1]; i++)
+               pv[ply][i] = pv[ply + 1][i];
+            pvLength[ply] = pvLength[ply + 1];
+            if (alpha >= beta)
+            {
+               cutoffs++;
+               if (moveCount == 1)
+                  firstMoveCutoffs++;
+               if (quiet)
+                  heuristics.update(board, move, quiets, quietCount, ply, depth);
+               break;
+            }
+         }
+      }
+      if (quiet)
+         quiets[quietCount++] = move;
+   }
+
+   Bound bound = best >= beta ? BOUND_LOWER : best > alphaOriginal ? BOUND_EXACT : BOUND_UPPER;
+   tt.store(board.getKey(), bestMove, scoreToTT(best, ply), staticEval, depth, bound);
+   return best;
+}
+
+/***************************************************
+ * SEARCHER : QUIESCENCE
+ * Past the horizon only captures and promotions are
+ * played, until the position is quiet enough for the
+ * static evaluation to be trusted. The side to move
+ * may stand pat rather than capture, unless it is in
+ * check, when every evasion is tried instead
+ *    INPUT ply  plies from the root
+ ***************************************************/
+int Searcher::quiescence(int ply, int alpha, int beta)
+{
+   pvLength[ply] = ply;
+   if (shouldStop())
+      return 0;
+   nodes.store(nodes.load(memory_order_relaxed) + 1, memory_order_relaxed);
+   if (ply > selDepth)
+      selDepth = ply;
+
+   if (board.isDraw())
+      return 0;
+   if (ply >= MAX_DEPTH)
+      return evaluate(board);
+
+   bool inCheck = board.inCheck();
+   int best = -SCORE_INFINITE;
+   int standPat = -SCORE_INFINITE;
+   if (!inCheck)
+   {
+      standPat = best = evaluate(board);
+      if (best >= beta)
+         return best;
+      if (best > alpha)
+         alpha = best;
+   }
+
+   MovePicker picker(board, heuristics, PackedMove(), ply, inCheck ? GEN_ALL : GEN_CAPTURES);
+   if (inCheck && picker.size() == 0)
+      return -SCORE_MATE + ply;
+
+   PackedMove move;
+   while (picker.next(move))
+   {
+      // delta pruning: even winning the piece for free leaves us below
+      // alpha. Nor is a capture worth playing if the exchange loses
+      if (!inCheck && !move.isPromotion())
+      {
+         PieceType victim = move.isEnPassant() ? PAWN : board.pieceOn(move.getDes());
+         if (standPat + PIECE_VALUES[victim] + DELTA_MARGIN <= alpha)
+            continue;
+         if (PIECE_VALUES[board.pieceOn(move.getSrc())] > PIECE_VALUES[victim] && board.see(move) < 0)
+            continue;
+      }
+
+      board.makeMove(move);
+      int score = -quiescence(ply + 1, -beta, -alpha);
+      board.unmakeMove();
+      if (aborted)
+         return 0;
+
+      if (score > best)
+      {
+         best = score;
+         if (score > alpha)
+         {
+            alpha = score;
+            pv[ply][ply] = move;
+            for (int i = ply + 1; i < pvLength[ply + 1]; i++)
+               pv[ply][i] = pv[ply + 1][i];
+            pvLength[ply] = pvLength[ply + 1];
+            if (alpha >= beta)
+               break;
+         }
+      }
+   }
+   return best;
+}
+
+/***************************************************
+ * SEARCHER : EXTEND PV
+ * A hit in the table ends the line recorded in pv,
+ * so carry it on with the moves the table remembers
+ ***************************************************/
+void Searcher::extendPV()
+{
+   for (int ply = 0; ply < pvLength[0]; ply++)
+      board.makeMove(pv[0][ply]);
+
+   TTEntry entry;
+   MoveList legal;
+   while (pvLength[0] < MAX_DEPTH && !board.isDraw() && tt.probe(board.getKey(), entry))
+   {
+      legal.clear();
+      generateLegalMoves(board, legal);
+      if (entry.move.isNull() || !legal.contains(entry.move))
+         break;
+      pv[0][pvLength[0]++] = entry.move;
+      board.makeMove(entry.move);
+   }
+
+   for (int ply = pvLength[0]; ply > 0; ply--)
+      board.unmakeMove();
+}
+
+/***************************************************
+ * SEARCHER : REPORT
+ * Tell the caller about the iteration just finished
+ ***************************************************/
+void Searcher::report(const SearchCallback& onIteration)
+{
+   SearchInfo info;
+   info.depth = result.depth;
+   info.selDepth = selDepth;
+   info.score = result.score;
+   for (size_t i = 0; i < searchers.size(); i++)
+      info.nodes += searchers[i]->getNodes();
+   info.time = elapsed();
+   info.nps = info.nodes * 1000 / (info.time > 0 ? info.time : 1);
+   info.hashfull = tt.hashfull();
+   info.ttProbes = ttProbes;
+   info.ttHits = ttHits;
+   info.cutoffs = cutoffs;
+   info.firstMoveCutoffs = firstMoveCutoffs;
+   info.researches = researches;
+   info.aspirationResearches = aspirationResearches;
+   info.pv = result.pv;
+   onIteration(info);
+}
+
+/***************************************************
+ * SEARCHER : RUN
+ * Iterative deepening from a copy of the root. Once
+ * there is a score to go by, each iteration starts
+ * with a narrow window around it, widening on the
+ * side it falls out of. An iteration cut off part
+ * way is thrown away
+ ***************************************************/
+void Searcher::run(const Board& root, const Limits& limits, chrono::steady_clock::time_point start,
+                   const SearchCallback& onIteration)
+{
+   board = root;
+   this->limits = limits;
+   this->start = start;
+   nodes.store(0, memory_order_relaxed);
+   aborted = false;
+   rootBest = PackedMove();
+   heuristics.clear();
+   result = SearchResult();
+   selDepth = 0;
+   ttProbes = ttHits = cutoffs = firstMoveCutoffs = researches = aspirationResearches = 0;
+
+   int maxDepth = (limits.depth > 0 && limits.depth < MAX_DEPTH) ? limits.depth : MAX_DEPTH;
+   for (rootDepth = 1; rootDepth <= maxDepth; rootDepth++)
+   {
+      if (skipDepth(id, rootDepth))
+         continue;
+
+      int delta = ASPIRATION_WINDOW;
+      int alpha = -SCORE_INFINITE;
+      int beta = SCORE_INFINITE;
+      if (rootDepth >= 4 && abs(result.score) < SCORE_MATE_IN_MAX)
+      {
+         alpha = max(result.score - delta, -SCORE_INFINITE);
+         beta = min(result.score + delta, SCORE_INFINITE);
+      }
+
+      int score;
+      for (;;)
+      {
+         score = negamax(rootDepth, 0, alpha, beta);
+         if (aborted || (score > alpha && score < beta))
+            break;
+
+         aspirationResearches++;
+         delta += delta;
+         if (score <= alpha)
+            alpha = delta > 500 ? -SCORE_INFINITE : max(score - delta, -SCORE_INFINITE);
+         else
+            beta = delta > 500 ? SCORE_INFINITE : min(score + delta, SCORE_INFINITE);
+      }
+      if (aborted)
+         break;
+
+      extendPV();
+      result.score = score;
+      result.depth = rootDepth;
+      result.pv.assign(pv[0], pv[0] + pvLength[0]);
+      result.move = rootBest = result.pv.empty() ? PackedMove() : result.pv[0];
+      if (id == 0 && onIteration)
+         report(onIteration);
+
+      // no move, or a forced mate already seen in full
+      if (result.move.isNull() || SCORE_MATE - abs(score) <= rootDepth)
+         break;
+   }
+
+   // the main thread is done, so the helpers are too
+   if (id == 0)
+      stopFlag.store(true, memory_order_relaxed);
+}
+
+/***************************************************
+ * SEARCH
+ * Start the helpers, search on this thread, and then
+ * take the deepest result any thread finished
+ ***************************************************/
+SearchResult search(const Board& board, const Limits& limits, const SearchCallback& onIteration)
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   if (searchers.empty())
+      setSearchThreads(1);
+
+   stopFlag.store(false, memory_order_relaxed);
+   tt.newSearch();
+
+   vector<thread> helpers;
+   for (size_t i = 1; i < searchers.size(); i++)
+      helpers.push_back(thread(&Searcher::run, searchers[i].get(), cref(board), cref(limits), start,
+                               SearchCallback()));
+   searchers[0]->run(board, limits, start, onIteration);
+   for (size_t i = 0; i < helpers.size(); i++)
+      helpers[i].join();
+
+   SearchResult result = searchers[0]->getResult();
+   result.nodes = 0;
+   for (size_t i = 0; i < searchers.size(); i++)
+   {
+      const SearchResult& other = searchers[i]->getResult();
+      if (other.depth > result.depth && !other.move.isNull())
+      {
+         uint64_t nodes = result.nodes;
+         result = other;
+         result.nodes = nodes;
+      }
+      result.nodes += searchers[i]->getNodes();
+   }
+   result.time = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+   return result;
+}
+
+/***************************************************
+ * STOP SEARCH
+ ***************************************************/
+void stopSearch()
+{
+   stopFlag.store(true, memory_order_relaxed);
+}
+
+/***************************************************
+ * SEARCH THREADS
+ * Each thread keeps its Searcher, and so its board,
+ * from one search to the next
+ ***************************************************/
+void setSearchThreads(int threads)
+{
+   if (threads < 1)
+      threads = 1;
+   if (threads > MAX_SEARCH_THREADS)
+      threads = MAX_SEARCH_THREADS;
+   searchers.clear();
+   for (int i = 0; i < threads; i++)
+      searchers.push_back(unique_ptr<Searcher>(new Searcher(i)));
+}
+
+int getSearchThreads()
+{
+   return searchers.empty() ? 1 : (int)searchers.size();
+}
+
+/***************************************************
+ * HASH
+ ***************************************************/
+void setHashSize(size_t megabytes)
+{
+   tt.resize(megabytes);
+}
+
+size_t getHashSize()
+{
+   return tt.getMegabytes();
+}
+
+void clearHash()
+{
+   tt.clear();
+}
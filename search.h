@@ -0,0 +1,112 @@
+/***********************************************************************
+ * Header File:
+ *    SEARCH : Choose a move
+ * Summary:
+ *    Negamax alpha-beta search with iterative deepening. The search
+ *    goes one ply deeper each iteration until a limit is reached, so
+ *    there is always a best move from the last finished iteration to
+ *    answer with, however early the search is cut off.
+ *
+ *    With more than one thread the search is "Lazy SMP": every thread
+ *    searches the same root on its own copy of the board, sharing only
+ *    the transposition table. Helpers skip some depths so the threads
+ *    spread over different iterations, and what one thread stores in
+ *    the table steers the others.
+ *
+ *    After every iteration the main thread reports what the search
+ *    has done so far through an optional callback, for a GUI to show
+ *    or for tuning the search to read.
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "board.h"
+#include "packedMove.h"
+
+const int MAX_DEPTH      = 64;                   // deepest the search will go
+const int SCORE_INFINITE = 32001;
+const int SCORE_MATE     = 32000;                // mated now; mate in n plies is SCORE_MATE - n
+const int SCORE_MATE_IN_MAX = SCORE_MATE - MAX_DEPTH;
+const int MAX_SEARCH_THREADS = 256;              // most threads setSearchThreads will start
+
+/***************************************************
+ * LIMITS
+ * When to stop searching. Zero means no limit; the
+ * search stops at whichever limit is reached first
+ ***************************************************/
+struct Limits
+{
+   Limits() : depth(0), nodes(0), movetime(0) {}
+
+   int      depth;     // plies
+   uint64_t nodes;     // positions visited
+   int64_t  movetime;  // milliseconds
+};
+
+/***************************************************
+ * SEARCH RESULT
+ * The outcome of the deepest finished iteration
+ ***************************************************/
+struct SearchResult
+{
+   SearchResult() : score(0), depth(0), nodes(0), time(0) {}
+
+   PackedMove              move;   // the best move, null if there is none
+   std::vector<PackedMove> pv;     // the line expected to follow, starting with move
+   int                     score;  // centipawns for the side to move
+   int                     depth;  // plies
+   uint64_t                nodes;  // positions visited by the whole search
+   int64_t                 time;   // milliseconds
+};
+
+/***************************************************
+ * SEARCH INFO
+ * Telemetry for one finished iteration. The counts
+ * are since the search began; all but the nodes are
+ * those of the main thread
+ ***************************************************/
+struct SearchInfo
+{
+   SearchInfo() : depth(0), selDepth(0), score(0), nodes(0), nps(0), time(0), hashfull(0),
+                  ttProbes(0), ttHits(0), cutoffs(0), firstMoveCutoffs(0),
+                  researches(0), aspirationResearches(0) {}
+
+   int      depth;                 // plies of the iteration
+   int      selDepth;              // deepest ply reached, quiescence included
+   int      score;                 // centipawns for the side to move
+   uint64_t nodes;                 // positions visited by every thread
+   uint64_t nps;                   // nodes per second
+   int64_t  time;                  // milliseconds
+   int      hashfull;              // permille of the table used this search
+   uint64_t ttProbes;              // table lookups
+   uint64_t ttHits;                // lookups that found the position
+   uint64_t cutoffs;               // nodes that failed high
+   uint64_t firstMoveCutoffs;      // those that did so on the first move
+   uint64_t researches;            // null window or reduced searches repeated
+   uint64_t aspirationResearches;  // root searches repeated with a wider window
+   std::vector<PackedMove> pv;
+
+   double ttHitRate() const         { return ttProbes ? (double)ttHits / ttProbes : 0.0;          }
+   double firstMoveCutoffRate() const { return cutoffs ? (double)firstMoveCutoffs / cutoffs : 0.0; }
+};
+
+typedef std::function<void(const SearchInfo&)> SearchCallback;
+
+// find the best move in a position; the board is not changed.
+// Only one search may run at a time. The callback, if any, is
+// called on this thread after each iteration
+SearchResult search(const Board& board, const Limits& limits,
+                    const SearchCallback& onIteration = SearchCallback());
+
+// end the running search early; it still returns its best move
+void stopSearch();
+
+// settings, not to be changed while a search is running
+void setSearchThreads(int threads);
+int  getSearchThreads();
+void setHashSize(size_t megabytes);   // throws bad_alloc, keeping the old table
+size_t getHashSize();
+void clearHash();
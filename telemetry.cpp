@@ -0,0 +1,43 @@
+/***********************************************************************
+ * Source File:
+ *    TELEMETRY : Search statistics for tuning
+ * Summary:
+ *    The JSON is written by hand: every value is a number or a move in
+ *    coordinate notation, so nothing needs escaping.
+ ************************************************************************/
+
+#include "telemetry.h"
+
+using namespace std;
+
+/***************************************************
+ * WRITE SEARCH INFO
+ * {"depth":10,"seldepth":24,"score":31,...,"pv":["e2e4","e7e5"]}
+ * The line is built first and written in one go, so
+ * lines from different threads do not interleave
+ ***************************************************/
+void writeSearchInfo(ostream& out, const SearchInfo& info)
+{
+   string line = "{\"depth\":" + to_string(info.depth)
+               + ",\"seldepth\":" + to_string(info.selDepth)
+               + ",\"score\":" + to_string(info.score)
+               + ",\"nodes\":" + to_string(info.nodes)
+               + ",\"nps\":" + to_string(info.nps)
+               + ",\"time_ms\":" + to_string(info.time)
+               + ",\"hashfull\":" + to_string(info.hashfull)
+               + ",\"tt_probes\":" + to_string(info.ttProbes)
+               + ",\"tt_hits\":" + to_string(info.ttHits)
+               + ",\"tt_hit_rate\":" + to_string(info.ttHitRate())
+               + ",\"cutoffs\":" + to_string(info.cutoffs)
+               + ",\"first_move_cutoffs\":" + to_string(info.firstMoveCutoffs)
+               + ",\"first_move_cutoff_rate\":" + to_string(info.firstMoveCutoffRate())
+               + ",\"researches\":" + to_string(info.researches)
+               + ",\"aspiration_researches\":" + to_string(info.aspirationResearches)
+               + ",\"pv\":[";
+   for (size_t i = 0; i < info.pv.size(); i++)
+      line += (i ? ",\"" : "\"") + info.pv[i].getCoordinates() + "\"";
+   line += "]}\n";
+
+   out << line;
+   out.flush();
+}
@@ -0,0 +1,20 @@
+/***********************************************************************
+ * Header File:
+ *    TELEMETRY : Search statistics for tuning
+ * Summary:
+ *    Writes what the search reports after each iteration as one line
+ *    of JSON, so a log of many searches can be read back by a script.
+ *    Pass writeSearchInfo to search() through a lambda to get a line
+ *    per iteration:
+ *
+ *       search(board, limits, [](const SearchInfo& info)
+ *                             { writeSearchInfo(cout, info); });
+ ************************************************************************/
+
+#pragma once
+
+#include <iostream>
+#include "search.h"
+
+// one JSON object on one line, ending with a newline
+void writeSearchInfo(std::ostream& out, const SearchInfo& info);
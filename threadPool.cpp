@@ -0,0 +1,143 @@
+/***********************************************************************
+ * Source File:
+ *    THREAD POOL : Worker threads that share out the work by stealing
+ * Summary:
+ *    The queues are short and a task is a whole subtree, so a mutex
+ *    per queue costs nothing measurable. A worker that finds nothing to
+ *    take sleeps until a task is queued, rather than spinning while the
+ *    others finish long tasks; a task that splits wakes it with the
+ *    pieces.
+ ************************************************************************/
+
+#include "threadPool.h"
+#define NDEBUG
+#include <cassert>
+
+using namespace std;
+
+/***************************************************
+ * THREAD POOL : CONSTRUCTOR
+ ***************************************************/
+ThreadPool::ThreadPool(int threads) : pending(0), queued(0), next(0), quit(false)
+{
+   if (threads < 1)
+      threads = 1;
+   for (int i = 0; i < threads; i++)
+      queues.push_back(unique_ptr<Queue>(new Queue));
+   for (int i = 0; i < threads; i++)
+      workers.push_back(thread(&ThreadPool::work, this, i));
+}
+
+/***************************************************
+ * THREAD POOL : DESTRUCTOR
+ * Finishes the outstanding tasks first
+ ***************************************************/
+ThreadPool::~ThreadPool()
+{
+   wait();
+   {
+      lock_guard<mutex> guard(lock);
+      quit = true;
+   }
+   wake.notify_all();
+   for (size_t i = 0; i < workers.size(); i++)
+      workers[i].join();
+}
+
+/***************************************************
+ * THREAD POOL : PUSH
+ ***************************************************/
+void ThreadPool::push(int worker, Task& task)
+{
+   pending.fetch_add(1);
+   {
+      lock_guard<mutex> guard(queues[worker]->lock);
+      queues[worker]->tasks.push_back(std::move(task));
+   }
+   queued.fetch_add(1);
+   // take the pool lock so a worker about to sleep cannot miss this
+   lock_guard<mutex> guard(lock);
+   wake.notify_one();
+}
+
+void ThreadPool::submit(Task task)
+{
+   push(next.fetch_add(1) % size(), task);
+}
+
+void ThreadPool::spawn(int worker, Task task)
+{
+   push(worker, task);
+}
+
+/***************************************************
+ * THREAD POOL : TAKE
+ * The newest task of our own, else the oldest task
+ * of the next worker that has any
+ ***************************************************/
+bool ThreadPool::take(int worker, Task& task)
+{
+   {
+      Queue& own = *queues[worker];
+      lock_guard<mutex> guard(own.lock);
+      if (!own.tasks.empty())
+      {
+         task = std::move(own.tasks.back());
+         own.tasks.pop_back();
+         queued.fetch_sub(1);
+         return true;
+      }
+   }
+
+   for (int i = 1; i < size(); i++)
+   {
+      Queue& victim = *queues[(worker + i) % size()];
+      lock_guard<mutex> guard(victim.lock);
+      if (!victim.tasks.empty())
+      {
+         task = std::move(victim.tasks.front());
+         victim.tasks.pop_front();
+         queued.fetch_sub(1);
+         return true;
+      }
+   }
+   return false;
+}
+
+/***************************************************
+ * THREAD POOL : WORK
+ * The loop each worker runs until the pool is destroyed
+ ***************************************************/
+void ThreadPool::work(int worker)
+{
+   Task task;
+   for (;;)
+   {
+      if (take(worker, task))
+      {
+         task(worker);
+         task = nullptr;
+         if (pending.fetch_sub(1) == 1)
+         {
+            lock_guard<mutex> guard(lock);
+            idle.notify_all();
+         }
+      }
+      else
+      {
+         unique_lock<mutex> guard(lock);
+         wake.wait(guard, [this] { return quit || queued.load() > 0; });
+         if (quit)
+            return;
+      }
+   }
+}
+
+/***************************************************
+ * THREAD POOL : WAIT
+ ***************************************************/
+void ThreadPool::wait()
+{
+   unique_lock<mutex> guard(lock);
+   idle.wait(guard, [this] { return pending.load() == 0; });
+}
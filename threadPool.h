@@ -0,0 +1,72 @@
+/***********************************************************************
+ * Header File:
+ *    THREAD POOL : Worker threads that share out the work by stealing
+ * Summary:
+ *    Each worker has its own queue of tasks. A task may hand the pool
+ *    more tasks, which go on the back of its own worker's queue, and a
+ *    worker always takes its next task from the back: the newest, and
+ *    so the smallest piece of a tree being split. A worker with nothing
+ *    left steals from the front of another's queue instead, taking the
+ *    oldest and so the biggest piece. Busy workers rarely touch each
+ *    other's queues, and the idle ones get real work when they do.
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***************************************************
+ * THREAD POOL
+ ***************************************************/
+class ThreadPool
+{
+public:
+   // a task is told which worker is running it
+   typedef std::function<void(int worker)> Task;
+
+   ThreadPool(int threads);
+   ~ThreadPool();
+
+   // getters
+   int size() const { return (int)queues.size(); }
+
+   // add a task from outside the pool
+   void submit(Task task);
+
+   // add a task from inside a task running on the given worker
+   void spawn(int worker, Task task);
+
+   // block until every task, and every task they added, has finished
+   void wait();
+
+private:
+   ThreadPool(const ThreadPool&);
+   ThreadPool& operator = (const ThreadPool&);
+
+   struct Queue
+   {
+      std::mutex       lock;
+      std::deque<Task> tasks;
+   };
+
+   void work(int worker);
+   bool take(int worker, Task& task);
+   void push(int worker, Task& task);
+
+   std::vector<std::unique_ptr<Queue> > queues;
+   std::vector<std::thread> workers;
+   std::atomic<int>         pending;   // tasks added but not yet finished
+   std::atomic<int>         queued;    // tasks in the queues, not yet taken
+   std::atomic<int>         next;      // queue the next outside task goes to
+   bool                     quit;
+   std::mutex               lock;      // guards quit and the sleeping below
+   std::condition_variable  wake;      // work arrived, or quitting
+   std::condition_variable  idle;      // pending reached zero
+};
@@ -0,0 +1,220 @@
+/***********************************************************************
+ * Source File:
+ *    TRANSPOSITION TABLE : Search results remembered by position
+ * Summary:
+ *    Allocation, probing and replacement. Every access is a relaxed
+ *    atomic load or store; the XOR check is what keeps concurrent
+ *    readers from trusting half-written entries.
+ ************************************************************************/
+
+#include "transposition.h"
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+/***************************************************
+ * PACK / UNPACK
+ ***************************************************/
+static uint64_t pack(PackedMove move, int score, int eval, int depth, Bound bound, unsigned int age)
+{
+   return  (uint64_t)move.getRaw()
+         | (uint64_t)(uint16_t)(int16_t)score << 16
+         | (uint64_t)(uint16_t)(int16_t)eval  << 32
+         | (uint64_t)(uint8_t)(depth + 1)     << 48
+         | (uint64_t)bound                    << 56
+         | (uint64_t)age                      << 58;
+}
+
+static int  depthOf(uint64_t data) { return (int)((data >> 48) & 0xff) - 1; }
+static Bound boundOf(uint64_t data) { return (Bound)((data >> 56) & 3);     }
+static unsigned int ageOf(uint64_t data) { return (unsigned int)(data >> 58); }
+
+/***************************************************
+ * TRANSPOSITION TABLE : CONSTRUCTOR
+ ***************************************************/
+TranspositionTable::TranspositionTable(size_t megabytes, bool hugePages) :
+   buckets(nullptr), count(0), age(0)
+{
+   resize(megabytes, hugePages);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+   release();
+}
+
+/***************************************************
+ * TRANSPOSITION TABLE : RESIZE
+ * Reallocate to the largest power of two buckets that
+ * fits in the given size. With huge pages on Linux the
+ * table is aligned to 2MB and the kernel is asked to
+ * back it with huge pages, which cuts TLB misses on
+ * random probes. The new table is allocated before the
+ * old one is freed, so if that throws bad_alloc the old
+ * table is still there to use. Not safe while a search
+ * is running.
+ ***************************************************/
+void TranspositionTable::resize(size_t megabytes, bool hugePages)
+{
+   size_t bytes = (megabytes ? megabytes : 1) << 20;
+   size_t newCount = 1;
+   while (newCount * 2 * sizeof(Bucket) <= bytes)
+      newCount *= 2;
+   bytes = newCount * sizeof(Bucket);
+
+   size_t alignment = 64;
+#if defined(__linux__)
+   if (hugePages && bytes >= (2u << 20))
+      alignment = 2u << 20;
+#else
+   (void)hugePages;
+#endif
+
+   void* p = nullptr;
+#if defined(_WIN32)
+   p = _aligned_malloc(bytes, alignment);
+#else
+   if (posix_memalign(&p, alignment, bytes) != 0)
+      p = nullptr;
+#endif
+   if (p == nullptr)
+      throw bad_alloc();
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+   if (alignment > 64)
+      madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+
+   release();
+   buckets = static_cast<Bucket*>(p);
+   count = newCount;
+   clear();
+}
+
+/***************************************************
+ * TRANSPOSITION TABLE : RELEASE
+ ***************************************************/
+void TranspositionTable::release()
+{
+#if defined(_WIN32)
+   _aligned_free(buckets);
+#else
+   free(buckets);
+#endif
+   buckets = nullptr;
+   count = 0;
+}
+
+/***************************************************
+ * TRANSPOSITION TABLE : CLEAR
+ * Forget everything. Not safe while a search is running
+ ***************************************************/
+void TranspositionTable::clear()
+{
+   for (size_t i = 0; i < count; i++)
+      for (int j = 0; j < BUCKET_SIZE; j++)
+      {
+         buckets[i].slots[j].check.store(0, memory_order_relaxed);
+         buckets[i].slots[j].data.store(0, memory_order_relaxed);
+      }
+   age = 0;
+}
+
+/***************************************************
+ * TRANSPOSITION TABLE : PROBE
+ * Look up a position
+ *   INPUT  key    The Zobrist key of the position
+ *   OUTPUT entry  What was stored, if found
+ *          return Whether the position was found
+ ***************************************************/
+bool TranspositionTable::probe(Key key, TTEntry& entry) const
+{
+   const Bucket& bucket = bucketOf(key);
+   for (int i = 0; i < BUCKET_SIZE; i++)
+   {
+      uint64_t data  = bucket.slots[i].data.load(memory_order_relaxed);
+      uint64_t check = bucket.slots[i].check.load(memory_order_relaxed);
+      if ((check ^ data) == key && boundOf(data) != BOUND_NONE)
+      {
+         entry.move  = PackedMove::fromRaw((uint16_t)data);
+         entry.score = (int16_t)(data >> 16);
+         entry.eval  = (int16_t)(data >> 32);
+         entry.depth = depthOf(data);
+         entry.bound = boundOf(data);
+         return true;
+      }
+   }
+   return false;
+}
+
+/***************************************************
+ * TRANSPOSITION TABLE : STORE
+ * Save a search result. The position's own entry is
+ * overwritten if present. Otherwise the entry that is
+ * shallowest and oldest in its bucket is replaced.
+ ***************************************************/
+void TranspositionTable::store(Key key, PackedMove move, int score, int eval, int depth, Bound bound)
+{
+   Bucket& bucket = bucketOf(key);
+   Slot* replace = &bucket.slots[0];
+   int worst = 0x7fffffff;
+
+   for (int i = 0; i < BUCKET_SIZE; i++)
+   {
+      Slot& slot = bucket.slots[i];
+      uint64_t data = slot.data.load(memory_order_relaxed);
+
+      // same position: keep the old move if we did not find a new one
+      if ((slot.check.load(memory_order_relaxed) ^ data) == key)
+      {
+         if (move.isNull())
+            move = PackedMove::fromRaw((uint16_t)data);
+         // a deeper result from this search is worth more than this one
+         if (bound != BOUND_EXACT && ageOf(data) == age && depthOf(data) > depth + 2)
+            return;
+         replace = &slot;
+         break;
+      }
+
+      // every search the entry has sat out counts as much as 8 plies
+      int value = depthOf(data) - 8 * (int)((age - ageOf(data)) & AGE_MASK);
+      if (value < worst)
+      {
+         worst = value;
+         replace = &slot;
+      }
+   }
+
+   uint64_t data = pack(move, score, eval, depth, bound, age);
+   replace->data.store(data, memory_order_relaxed);
+   replace->check.store(key ^ data, memory_order_relaxed);
+}
+
+/***************************************************
+ * TRANSPOSITION TABLE : HASHFULL
+ * Permille of a sample of a thousand entries that
+ * were written during the current search
+ ***************************************************/
+int TranspositionTable::hashfull() const
+{
+   int used = 0;
+   size_t sample = count < 250 ? count : 250;
+   for (size_t i = 0; i < sample; i++)
+      for (int j = 0; j < BUCKET_SIZE; j++)
+      {
+         uint64_t data = buckets[i].slots[j].data.load(memory_order_relaxed);
+         if (boundOf(data) != BOUND_NONE && ageOf(data) == age)
+            used++;
+      }
+   return sample ? (int)(used * 1000 / (sample * BUCKET_SIZE)) : 0;
+}
@@ -0,0 +1,91 @@
+/***********************************************************************
+ * Header File:
+ *    TRANSPOSITION TABLE : Search results remembered by position
+ * Summary:
+ *    A fixed-size hash table of search results keyed by the Zobrist
+ *    key of the position. Entries live in buckets of four that share
+ *    one cache line. Each entry stores its key XORed with its data, so
+ *    a torn write by another thread reads back as a miss rather than a
+ *    wrong result. That lets every search thread share one table with
+ *    no locks.
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "packedMove.h"
+#include "zobrist.h"
+
+/***************************************************
+ * BOUND
+ * How a stored score relates to the true score
+ ***************************************************/
+enum Bound
+{
+   BOUND_NONE  = 0,
+   BOUND_UPPER = 1,   // the true score is at most this (fail low)
+   BOUND_LOWER = 2,   // the true score is at least this (fail high)
+   BOUND_EXACT = 3
+};
+
+/***************************************************
+ * TT ENTRY
+ * One search result, unpacked
+ ***************************************************/
+struct TTEntry
+{
+   PackedMove move;   // best or refutation move, may be null
+   int        score;  // score from the search
+   int        eval;   // static evaluation of the position
+   int        depth;  // remaining depth the score was searched to
+   Bound      bound;
+};
+
+/***************************************************
+ * TRANSPOSITION TABLE
+ ***************************************************/
+class TranspositionTable
+{
+public:
+   TranspositionTable(size_t megabytes = 16, bool hugePages = true);
+   ~TranspositionTable();
+
+   // getters
+   bool probe(Key key, TTEntry& entry) const;
+   size_t getMegabytes() const { return (count * sizeof(Bucket)) >> 20; }
+   int hashfull() const;
+
+   // setters
+   void resize(size_t megabytes, bool hugePages = true);
+   void clear();
+   void newSearch() { age = (age + 1) & AGE_MASK; }
+   void store(Key key, PackedMove move, int score, int eval, int depth, Bound bound);
+
+private:
+   TranspositionTable(const TranspositionTable&);
+   TranspositionTable& operator = (const TranspositionTable&);
+
+   static const int BUCKET_SIZE = 4;
+   static const unsigned int AGE_MASK = 0x3f;
+
+   // data packs move:16 score:16 eval:16 depth:8 bound:2 age:6
+   struct Slot
+   {
+      std::atomic<uint64_t> check;  // key ^ data
+      std::atomic<uint64_t> data;
+   };
+
+   struct Bucket
+   {
+      Slot slots[BUCKET_SIZE];
+   };
+
+   void release();
+   Bucket& bucketOf(Key key) const { return buckets[key & (count - 1)]; }
+
+   Bucket*      buckets;   // count buckets, aligned to a cache line or a page
+   size_t       count;     // always a power of two
+   unsigned int age;       // bumped every search so old entries go first
+};
@@ -0,0 +1,437 @@
+/***********************************************************************
+ * Source File:
+ *    UCI : The Universal Chess Interface
+ * Summary:
+ *    Commands are parsed a word at a time. Anything not understood is
+ *    ignored, as the protocol asks. The search thread and the loop
+ *    both write to the output, so every line goes out under a lock.
+ ************************************************************************/
+
+#include "uci.h"
+#include "board.h"
+#include "nnue.h"
+#include "notation.h"
+#include "search.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// time kept back for the GUI and the pipe on every move
+static const int64_t MOVE_OVERHEAD = 30;
+
+// a ponder with no clock, depth or node limit: after ponderhit only "stop" ends it
+static const int64_t PONDER_UNLIMITED = -1;
+
+/***************************************************
+ * ENGINE
+ * The state the loop keeps between commands
+ ***************************************************/
+class Engine
+{
+public:
+   Engine(ostream& out) : out(out), searching(false), waiting(false), ponderTime(0) {}
+   ~Engine() { stop(); }
+
+   void setPosition(istringstream& words);
+   void go(istringstream& words);
+   void stop();
+   void ponderHit();
+   void setOption(istringstream& words);
+   void send(const string& line);
+
+private:
+   void think(Limits limits);
+   void startTimer(int64_t movetime);
+   void release();
+   string infoLine(const SearchInfo& info) const;
+
+   ostream& out;
+   mutex outLock;
+
+   thread searcher;
+   thread timer;
+   mutex lock;                   // guards the flags and the timer's wait
+   condition_variable wake;
+   bool searching;               // a search thread is running
+   bool waiting;                 // infinite or ponder: hold bestmove until told
+   int64_t ponderTime;           // the time to use once a ponder is hit, 0 for none,
+                                 // PONDER_UNLIMITED when nothing would end the search
+
+   Board board;
+};
+
+/***************************************************
+ * ENGINE : SEND
+ * One line, whole, whichever thread sends it
+ ***************************************************/
+void Engine::send(const string& line)
+{
+   lock_guard<mutex> guard(outLock);
+   out << line << endl;
+}
+
+/***************************************************
+ * ENGINE : SET POSITION
+ * position startpos|fen <fen> [moves <move>...]
+ * The moves are in coordinate notation. Playing them
+ * keeps the history, so the search sees repetitions
+ ***************************************************/
+void Engine::setPosition(istringstream& words)
+{
+   string word;
+   words >> word;
+   string fen;
+   if (word == "startpos")
+   {
+      fen = START_FEN;
+      words >> word;
+   }
+   else if (word == "fen")
+   {
+      while (words >> word && word != "moves")
+         fen += (fen.empty() ? "" : " ") + word;
+   }
+   else
+      return;
+
+   try
+   {
+      board.loadFEN(fen);
+   }
+   catch (const string& error)
+   {
+      send("info string " + error);
+      board.loadFEN(START_FEN);
+      return;
+   }
+
+   if (word != "moves")
+      return;
+   while (words >> word)
+   {
+      PackedMove move;
+      NotationError error = readUCI(board, word, move);
+      if (error != NOTATION_OK)
+      {
+         send(string("info string ") + notationErrorText(error) + " " + word);
+         return;
+      }
+      board.makeMove(move);
+   }
+}
+
+/***************************************************
+ * ENGINE : INFO LINE
+ * info depth 12 seldepth 20 score cp 31 nodes ... pv ...
+ ***************************************************/
+string Engine::infoLine(const SearchInfo& info) const
+{
+   string score;
+   if (info.score >= SCORE_MATE_IN_MAX)
+      score = "mate " + to_string((SCORE_MATE - info.score + 1) / 2);
+   else if (info.score <= -SCORE_MATE_IN_MAX)
+      score = "mate " + to_string(-(SCORE_MATE + info.score) / 2);
+   else
+      score = "cp " + to_string(info.score);
+
+   string line = "info depth " + to_string(info.depth)
+               + " seldepth " + to_string(info.selDepth)
+               + " score " + score
+               + " nodes " + to_string(info.nodes)
+               + " nps " + to_string(info.nps)
+               + " hashfull " + to_string(info.hashfull)
+               + " time " + to_string(info.time)
+               + " pv";
+   for (PackedMove move : info.pv)
+      line += " " + move.getCoordinates();
+   return line;
+}
+
+/***************************************************
+ * ENGINE : GO
+ * go [depth d] [nodes n] [movetime ms] [wtime ms]
+ *    [btime ms] [winc ms] [binc ms] [movestogo n]
+ *    [infinite] [ponder]
+ * The clock is turned into a time for this move. An
+ * infinite search ignores the clock and runs until
+ * "stop". A ponder searches without limit until
+ * "ponderhit" starts that clock, or "stop" ends it
+ ***************************************************/
+void Engine::go(istringstream& words)
+{
+   stop();
+
+   Limits limits;
+   int64_t time[2] = { 0, 0 };  // by isWhite
+   int64_t inc[2] = { 0, 0 };
+   int movesToGo = 0;
+   bool infinite = false;
+   bool ponder = false;
+
+   string word;
+   while (words >> word)
+   {
+      if (word == "depth")
+         words >> limits.depth;
+      else if (word == "nodes")
+         words >> limits.nodes;
+      else if (word == "movetime")
+         words >> limits.movetime;
+      else if (word == "wtime")
+         words >> time[true];
+      else if (word == "btime")
+         words >> time[false];
+      else if (word == "winc")
+         words >> inc[true];
+      else if (word == "binc")
+         words >> inc[false];
+      else if (word == "movestogo")
+         words >> movesToGo;
+      else if (word == "infinite")
+         infinite = true;
+      else if (word == "ponder")
+         ponder = true;
+   }
+
+   // spend an even share of what is left, plus most of the increment
+   int64_t movetime = limits.movetime;
+   bool isWhite = board.whiteTurn();
+   if (time[isWhite] > 0)
+   {
+      int64_t share = time[isWhite] / (movesToGo > 0 ? movesToGo : 30) + inc[isWhite] * 3 / 4;
+      int64_t most = time[isWhite] - MOVE_OVERHEAD;
+      movetime = share < most ? share : most;
+      if (movetime < 10)
+         movetime = 10;
+      if (limits.movetime > 0 && limits.movetime < movetime)
+         movetime = limits.movetime;
+   }
+
+   // the timer, not the search, watches the clock so a ponder can start it late
+   limits.movetime = 0;
+   {
+      lock_guard<mutex> guard(lock);
+      searching = true;
+      waiting = infinite || ponder;
+      ponderTime = 0;
+      if (ponder)
+         ponderTime = movetime > 0 || limits.depth > 0 || limits.nodes > 0 ? movetime : PONDER_UNLIMITED;
+   }
+   searcher = thread(&Engine::think, this, limits);
+   if (!ponder && !infinite && movetime > 0)
+      startTimer(movetime);
+}
+
+/***************************************************
+ * ENGINE : THINK
+ * The search thread: search, then answer bestmove.
+ * An infinite or ponder search that ends on its own
+ * holds the answer until it is told to stop
+ ***************************************************/
+void Engine::think(Limits limits)
+{
+   SearchResult result = search(board, limits,
+                                [this](const SearchInfo& info) { send(infoLine(info)); });
+
+   {
+      unique_lock<mutex> guard(lock);
+      wake.wait(guard, [this] { return !waiting; });
+      searching = false;
+   }
+   wake.notify_all();
+
+   string line = "bestmove " + (result.move.isNull() ? string("0000") : result.move.getCoordinates());
+   if (result.pv.size() > 1)
+      line += " ponder " + result.pv[1].getCoordinates();
+   send(line);
+}
+
+/***************************************************
+ * ENGINE : START TIMER
+ * Stop the search once the time for the move is up,
+ * or sooner if the search finishes first
+ ***************************************************/
+void Engine::startTimer(int64_t movetime)
+{
+   auto deadline = chrono::steady_clock::now() + chrono::milliseconds(movetime);
+   timer = thread([this, deadline]
+   {
+      unique_lock<mutex> guard(lock);
+      if (!wake.wait_until(guard, deadline, [this] { return !searching; }))
+         stopSearch();
+   });
+}
+
+/***************************************************
+ * ENGINE : RELEASE
+ * Let a held search thread answer
+ ***************************************************/
+void Engine::release()
+{
+   {
+      lock_guard<mutex> guard(lock);
+      waiting = false;
+   }
+   wake.notify_all();
+}
+
+/***************************************************
+ * ENGINE : STOP
+ * End the search, if any, and wait for its bestmove.
+ * A search that has not quite started would clear the
+ * stop, so it is asked again until it is done
+ ***************************************************/
+void Engine::stop()
+{
+   if (searcher.joinable())
+   {
+      release();
+      for (;;)
+      {
+         stopSearch();
+         unique_lock<mutex> guard(lock);
+         if (wake.wait_for(guard, chrono::milliseconds(1), [this] { return !searching; }))
+            break;
+      }
+      searcher.join();
+   }
+   if (timer.joinable())
+      timer.join();
+}
+
+/***************************************************
+ * ENGINE : PONDER HIT
+ * The opponent played the move we were pondering,
+ * so the search carries on as a normal one, timed
+ * from now. With nothing to time it by, it says so
+ * and searches until "stop"
+ ***************************************************/
+void Engine::ponderHit()
+{
+   int64_t movetime;
+   {
+      lock_guard<mutex> guard(lock);
+      if (!searching)
+         return;
+      movetime = ponderTime;
+      ponderTime = 0;
+   }
+   release();
+   if (movetime > 0)
+      startTimer(movetime);
+   else if (movetime == PONDER_UNLIMITED)
+      send("info string ponderhit with no clock: searching until stop");
+}
+
+/***************************************************
+ * ENGINE : SET OPTION
+ * setoption name <name> [value <value>]
+ ***************************************************/
+void Engine::setOption(istringstream& words)
+{
+   stop();
+
+   string word;
+   string name;
+   string value;
+   words >> word;
+   while (words >> word && word != "value")
+      name += (name.empty() ? "" : " ") + word;
+   while (words >> word)
+      value += (value.empty() ? "" : " ") + word;
+
+   if (name == "Hash")
+   {
+      int megabytes = atoi(value.c_str());
+      try
+      {
+         setHashSize(megabytes < 1 ? 1 : (size_t)megabytes);
+      }
+      catch (const bad_alloc&)
+      {
+         send("info string cannot allocate " + to_string(megabytes) + " MB of hash, keeping " +
+              to_string(getHashSize()) + " MB");
+      }
+   }
+   else if (name == "Threads")
+      setSearchThreads(atoi(value.c_str()));
+   else if (name == "Clear Hash")
+      clearHash();
+   else if (name == "EvalFile")
+   {
+      // the boards being kept up to date must start from the new network
+      try
+      {
+         if (value.empty() || value == "<empty>")
+            setNetwork(nullptr);
+         else
+            loadNetwork(value);
+         board.refreshAccumulator();
+         send(nnueNetwork ? "info string NNUE evaluation from " + value
+                          : string("info string handcrafted evaluation"));
+      }
+      catch (const string& error)
+      {
+         send("info string " + error);
+      }
+   }
+}
+
+/***************************************************
+ * UCI LOOP
+ ***************************************************/
+void uciLoop(istream& in, ostream& out)
+{
+   Engine engine(out);
+
+   string line;
+   while (getline(in, line))
+   {
+      istringstream words(line);
+      string command;
+      words >> command;
+
+      if (command == "uci")
+      {
+         engine.send("id name Chess\n"
+                     "id author JasonGeppelt\n"
+                     "option name Hash type spin default 16 min 1 max 65536\n"
+                     "option name Threads type spin default 1 min 1 max " + to_string(MAX_SEARCH_THREADS) + "\n"
+                     "option name Clear Hash type button\n"
+                     "option name Ponder type check default false\n"
+                     "option name EvalFile type string default <empty>\n"
+                     "uciok");
+      }
+      else if (command == "isready")
+         engine.send("readyok");
+      else if (command == "ucinewgame")
+      {
+         engine.stop();
+         clearHash();
+      }
+      else if (command == "setoption")
+         engine.setOption(words);
+      else if (command == "position")
+      {
+         engine.stop();
+         engine.setPosition(words);
+      }
+      else if (command == "go")
+         engine.go(words);
+      else if (command == "stop")
+         engine.stop();
+      else if (command == "ponderhit")
+         engine.ponderHit();
+      else if (command == "quit")
+         break;
+   }
+}
@@ -0,0 +1,22 @@
+/***********************************************************************
+ * Header File:
+ *    UCI : The Universal Chess Interface
+ * Summary:
+ *    The text protocol chess GUIs, match servers and tournament tools
+ *    use to drive an engine over its standard input and output. The
+ *    loop reads one command a line and answers on the output. A search
+ *    runs on its own thread so that "stop" and "ponderhit" are read
+ *    while it thinks.
+ *
+ *    Supported: uci, isready, ucinewgame, setoption (Hash, Threads,
+ *    Clear Hash, Ponder), position, go (depth, nodes, movetime, wtime,
+ *    btime, winc, binc, movestogo, infinite, ponder), stop, ponderhit
+ *    and quit.
+ ************************************************************************/
+
+#pragma once
+
+#include <iostream>
+
+// read commands until "quit" or the end of the input
+void uciLoop(std::istream& in, std::ostream& out);
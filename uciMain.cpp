@@ -0,0 +1,17 @@
+/**********************************************************************
+ * UCI Main file
+ * The engine without the board on the screen, speaking the Universal
+ * Chess Interface on standard input and output so a chess GUI, match
+ * server or tournament manager can play it
+ **********************************************************************/
+
+#include "uci.h"
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+   uciLoop(cin, cout);
+   return 0;
+}
@@ -0,0 +1,69 @@
+/***********************************************************************
+ * Source File:
+ *    ZOBRIST : Random keys that hash a position into 64 bits
+ * Summary:
+ *    The keys come from a fixed seed so a position hashes the same on
+ *    every run, which matters for keys stored in files
+ ************************************************************************/
+
+#include "zobrist.h"
+
+Key zobristPieces[2][7][64];
+Key zobristBlack;
+Key zobristCastling[16];
+Key zobristEnPassant[8];
+
+/***************************************************
+ * RANDOM KEY
+ * xorshift64*
+ ***************************************************/
+static Key randomKey(Key& state)
+{
+   state ^= state >> 12;
+   state ^= state << 25;
+   state ^= state >> 27;
+   return state * 2685821657736338717ULL;
+}
+
+/***************************************************
+ * BUILD KEYS
+ ***************************************************/
+static bool buildKeys()
+{
+   Key state = 1070372ULL;
+
+   for (int isWhite = 0; isWhite < 2; isWhite++)
+      for (int pt = SPACE; pt <= PAWN; pt++)
+         for (int sq = 0; sq < 64; sq++)
+            zobristPieces[isWhite][pt][sq] = (pt == SPACE) ? 0 : randomKey(state);
+
+   zobristBlack = randomKey(state);
+
+   // each right gets a key and a combination is the XOR of its rights
+   Key rights[4];
+   for (int i = 0; i < 4; i++)
+      rights[i] = randomKey(state);
+   for (int castling = 0; castling < 16; castling++)
+   {
+      zobristCastling[castling] = 0;
+      for (int i = 0; i < 4; i++)
+         if (castling & (1 << i))
+            zobristCastling[castling] ^= rights[i];
+   }
+
+   for (int col = 0; col < 8; col++)
+      zobristEnPassant[col] = randomKey(state);
+
+   return true;
+}
+
+/***************************************************
+ * INIT ZOBRIST
+ * Build the keys exactly once, even when called
+ * from several threads at the same time
+ ***************************************************/
+void initZobrist()
+{
+   static const bool initialized = buildKeys();
+   (void)initialized;
+}
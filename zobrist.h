@@ -0,0 +1,24 @@
+/***********************************************************************
+ * Header File:
+ *    ZOBRIST : Random keys that hash a position into 64 bits
+ * Summary:
+ *    A position's key is the XOR of one random number for each piece on
+ *    each square, plus numbers for the side to move, the castling rights
+ *    and the en-passant file. Because XOR undoes itself, the Board keeps
+ *    its key current by XORing only what each move changes.
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include "pieceType.h"
+
+typedef uint64_t Key;
+
+extern Key zobristPieces[2][7][64]; // indexed by [isWhite][PieceType][square]
+extern Key zobristBlack;            // black to move
+extern Key zobristCastling[16];     // indexed by the CastlingRight bits
+extern Key zobristEnPassant[8];     // indexed by the column of the en-passant square
+
+// build the keys. Safe to call more than once
+void initZobrist();